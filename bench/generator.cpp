@@ -0,0 +1,122 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "generator.h"
+
+ExpressionGenerator::ExpressionGenerator(std::uint64_t seed)
+    : state(seed)
+{
+}
+
+const char* ExpressionGenerator::name(Shape shape)
+{
+    switch (shape) {
+    case Shape::Chain:
+        return "chain";
+    case Shape::Balanced:
+        return "balanced";
+    case Shape::Nested:
+        return "nested";
+    case Shape::Sum:
+        return "sum";
+    case Shape::Variables:
+        return "variables";
+    }
+    return "unknown";
+}
+
+const std::vector<ExpressionGenerator::Shape>& ExpressionGenerator::shapes()
+{
+    static const std::vector<Shape> all
+        = { Shape::Chain, Shape::Balanced, Shape::Nested, Shape::Sum, Shape::Variables };
+    return all;
+}
+
+std::string ExpressionGenerator::variable(std::size_t number)
+{
+    return "v" + std::to_string(number);
+}
+
+std::uint64_t ExpressionGenerator::next()
+{
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+char ExpressionGenerator::digit()
+{
+    return static_cast<char>('1' + next() % 9);
+}
+
+char ExpressionGenerator::additive()
+{
+    return next() % 2 ? '+' : '-';
+}
+
+std::string ExpressionGenerator::generate(Shape shape, std::size_t operands)
+{
+    std::string out;
+    if (operands == 0)
+        return out;
+    out.reserve(operands * 8);
+
+    switch (shape) {
+    case Shape::Chain:
+        // multiply only pairs of operands, so the values stay small
+        out += digit();
+        for (std::size_t i = 1; i < operands; ++i) {
+            out += i % 3 == 1 ? '*' : additive();
+            out += digit();
+        }
+        break;
+    case Shape::Balanced:
+        balanced(out, operands, true);
+        break;
+    case Shape::Nested:
+        for (std::size_t i = 1; i < operands; ++i) {
+            out += digit();
+            out += additive();
+            out += '(';
+        }
+        out += digit();
+        out.append(operands - 1, ')');
+        break;
+    case Shape::Sum:
+        out += digit();
+        for (std::size_t i = 1; i < operands; ++i) {
+            out += additive();
+            out += digit();
+        }
+        break;
+    case Shape::Variables:
+        // every other operand is a variable times a number
+        for (std::size_t i = 0; i < operands; i += 2) {
+            if (i > 0)
+                out += additive();
+            out += variable(next() % variableCount);
+            if (i + 1 < operands) {
+                out += '*';
+                out += digit();
+            }
+        }
+        break;
+    }
+    return out;
+}
+
+void ExpressionGenerator::balanced(std::string& out, std::size_t operands, bool top)
+{
+    if (operands == 1) {
+        out += digit();
+        return;
+    }
+    if (!top)
+        out += '(';
+    std::size_t left = operands / 2;
+    balanced(out, left, false);
+    // multiply only pairs of operands, so the values stay small
+    out += operands == 2 ? '*' : additive();
+    balanced(out, operands - left, false);
+    if (!top)
+        out += ')';
+}
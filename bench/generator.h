@@ -0,0 +1,73 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class ExpressionGenerator
+ * @brief Generates expressions of a given shape and size for the
+ *        benchmarks.
+ *
+ *        The same seed always yields the same expressions, on any
+ *        platform and with any standard library, so results from
+ *        different builds are measured on identical inputs.  Only
+ *        addition, subtraction and multiplication of small numbers are
+ *        used, so evaluation never divides by zero.
+ */
+class ExpressionGenerator {
+public:
+    // The shapes of expression that can be generated.
+    enum class Shape {
+        // a long run of operators of mixed precedence: 3-5*2+7...
+        Chain,
+        // a complete binary tree: ((3+5)-(2*7))+((...)-(...))
+        Balanced,
+        // parentheses nested as deep as there are operands: 3-(5+(2-(...)))
+        Nested,
+        // one wide sum: 3+5+2+7...
+        Sum,
+        // a sum of products of variables and numbers: v3*2+v17-v5*4...
+        Variables
+    };
+
+    // Ctor.
+    explicit ExpressionGenerator(std::uint64_t seed);
+
+    // Return the name of a shape.
+    static const char* name(Shape shape);
+
+    // Return every shape.
+    static const std::vector<Shape>& shapes();
+
+    // Return the name of the variable with the designated number; the
+    // Variables shape uses variables numbered 0 up to variableCount.
+    static std::string variable(std::size_t number);
+
+    // Number of distinct variables the Variables shape uses.
+    static constexpr std::size_t variableCount = 64;
+
+    // Return an expression of the designated shape with the designated
+    // number of operands.
+    std::string generate(Shape shape, std::size_t operands);
+
+private:
+    // Return the next pseudo-random number (splitmix64).
+    std::uint64_t next();
+
+    // Return a pseudo-random operand from 1 to 9.
+    char digit();
+
+    // Return a pseudo-random choice of + or -.
+    char additive();
+
+    // Append a balanced tree with the designated number of operands.
+    void balanced(std::string& out, std::size_t operands, bool top);
+
+    // The generator's state.
+    std::uint64_t state;
+};
+
+#endif // GENERATOR_H
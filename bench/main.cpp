@@ -0,0 +1,269 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "core/getopt.h"
+#include "core/work_stealing_pool.h"
+#include "generator.h"
+#include "interpreter/interpreter.h"
+#include "interpreter/pratt_parser.h"
+#include "interpreter/symbol.h"
+#include "interpreter/variable_map.h"
+#include "null_buffer.h"
+#include "output_sink.h"
+#include "tree/expression_tree.h"
+#include "tree/expression_tree_iterator.h"
+#include "tree/parallel_evaluator.h"
+#include "tree/variant_tree.h"
+#include "visitors/evaluation.h"
+#include "visitors/print.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Results are accumulated here so no stage can be optimized away.
+static volatile long long sink;
+
+// The timings of one stage on one expression.
+struct Result {
+    std::string shape;
+    std::string stage;
+    std::size_t nodes;
+    // Nanoseconds taken by each repetition, sorted.
+    std::vector<double> times;
+
+    [[nodiscard]] double median() const { return times[times.size() / 2]; }
+    [[nodiscard]] double best() const { return times.front(); }
+};
+
+// What's being measured, from the command line.
+struct Config {
+    std::size_t operands = 10000;
+    std::size_t repetitions = 15;
+    std::uint64_t seed = 1;
+    std::size_t threads = 0;
+    std::string json;
+};
+
+// Time a stage.  prepare runs before every repetition without being
+// timed; run is what's timed.
+static Result measure(const std::string& shape, const std::string& stage, std::size_t nodes,
+    std::size_t repetitions, const std::function<void()>& prepare,
+    const std::function<void()>& run)
+{
+    Result result { shape, stage, nodes, {} };
+    // the first run only warms up caches and the allocator
+    for (std::size_t i = 0; i <= repetitions; ++i) {
+        prepare();
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto stop = std::chrono::steady_clock::now();
+        if (i > 0)
+            result.times.push_back(std::chrono::duration<double, std::nano>(stop - start).count());
+    }
+    std::sort(result.times.begin(), result.times.end());
+    return result;
+}
+
+// Visit every node of the tree in the designated order.
+static void traverse(const ExpressionTree& tree, const std::string& order, Visitor& visitor)
+{
+    std::for_each(
+        tree.begin(order), tree.end(order), [&visitor](auto node) { node.accept(visitor); });
+}
+
+// Run every stage on one expression.
+static void benchmark(const Config& config, ExpressionGenerator::Shape shape,
+    std::vector<Result>& results)
+{
+    ExpressionGenerator generator(config.seed);
+    const std::string name = ExpressionGenerator::name(shape);
+    const std::string expression = generator.generate(shape, config.operands);
+    const auto none = [] { };
+
+    VariableMap variables;
+    for (std::size_t i = 0; i < ExpressionGenerator::variableCount; ++i)
+        variables.set(ExpressionGenerator::variable(i), static_cast<int>(i % 7) + 1);
+
+    ExpressionTree tree = Interpreter::interpret(variables, expression);
+    std::size_t nodes = std::distance(tree.begin("pre-order"), tree.end("pre-order"));
+    auto add = [&](const std::string& stage, const std::function<void()>& prepare,
+                   const std::function<void()>& run) {
+        results.push_back(measure(name, stage, nodes, config.repetitions, prepare, run));
+    };
+
+    // parsing and building are timed separately, and together
+    std::list<Symbol*> symbols;
+    auto parse = [&] { Interpreter::parse(variables, expression, symbols); };
+    auto release = [&] {
+        if (!symbols.empty())
+            delete symbols.back();
+        symbols.clear();
+    };
+    add("parse", release, parse);
+    release();
+    ComponentNode* root = nullptr;
+    add(
+        "build",
+        [&] {
+            delete root;
+            release();
+            parse();
+        },
+        [&] { root = symbols.back()->build(); });
+    delete root;
+    release();
+    add("interpret", none, [&] { sink = Interpreter::interpret(variables, expression).item(); });
+    add("interpret-flat", none,
+        [&] { sink = Interpreter::interpretFlat(variables, expression).item(); });
+    add("pratt", none, [&] { sink = PrattParser::parse(variables, expression).item(); });
+
+    // each traversal visits every node with a visitor that does nothing
+    // but count, so only the iterator's cost is measured
+    for (const char* order : { "in-order", "pre-order", "post-order", "level-order" }) {
+        add(std::string("traverse-") + order, none, [&] {
+            std::size_t visited = 0;
+            std::for_each(tree.begin(order), tree.end(order), [&visited](auto) { ++visited; });
+            sink = static_cast<long long>(visited);
+        });
+    }
+
+    add("evaluate", none, [&] {
+        EvaluationVisitor visitor(variables);
+        traverse(tree, "post-order", visitor);
+        sink = visitor.total();
+    });
+
+    std::unique_ptr<Bytecode> program;
+    add("compile", none, [&] { program = std::make_unique<Bytecode>(tree.compile()); });
+    add("bytecode", none, [&] {
+        int result = 0;
+        program->run(variables, result);
+        sink = result;
+    });
+
+    std::unique_ptr<VariantTree> variant;
+    add("variant-build", none, [&] { variant = std::make_unique<VariantTree>(tree); });
+    add("variant", none, [&] {
+        int result = 0;
+        variant->evaluate(variables, result);
+        sink = result;
+    });
+
+    if (config.threads > 0) {
+        WorkStealingPool pool(config.threads);
+        ParallelEvaluator parallel(*variant, pool);
+        add("parallel", none, [&] {
+            int result = 0;
+            parallel.evaluate(variables, result);
+            sink = result;
+        });
+    }
+
+    NullBuffer discard;
+    std::ostream nowhere(&discard);
+    add("print", none, [&] {
+        OutputSink os(nowhere);
+        PrintVisitor visitor(os);
+        traverse(tree, "in-order", visitor);
+    });
+}
+
+// Escape a string for JSON; the names used here never need more.
+static std::string quoted(const std::string& text)
+{
+    return '"' + text + '"';
+}
+
+static void writeJson(std::ostream& os, const Config& config, const std::vector<Result>& results)
+{
+    os << "{\n  \"config\": {"
+       << "\"operands\": " << config.operands << ", \"repetitions\": " << config.repetitions
+       << ", \"seed\": " << config.seed << ", \"threads\": " << config.threads
+       << ", \"compiler\": " << quoted(__VERSION__) << "},\n  \"results\": [\n";
+    os << std::fixed << std::setprecision(3);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        os << "    {\"shape\": " << quoted(r.shape) << ", \"stage\": " << quoted(r.stage)
+           << ", \"nodes\": " << r.nodes << ", \"median_ns\": " << r.median()
+           << ", \"best_ns\": " << r.best() << ", \"ns_per_node\": " << r.median() / r.nodes
+           << ", \"best_ns_per_node\": " << r.best() / r.nodes << "}"
+           << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    os << "  ]\n}\n";
+}
+
+static void writeTable(std::ostream& os, const std::vector<Result>& results)
+{
+    os << std::left << std::setw(10) << "shape" << std::setw(22) << "stage" << std::right
+       << std::setw(9) << "nodes" << std::setw(14) << "ns/node" << std::setw(14) << "best"
+       << '\n';
+    os << std::fixed << std::setprecision(2);
+    for (const auto& r : results)
+        os << std::left << std::setw(10) << r.shape << std::setw(22) << r.stage << std::right
+           << std::setw(9) << r.nodes << std::setw(14) << r.median() / r.nodes << std::setw(14)
+           << r.best() / r.nodes << '\n';
+}
+
+static void usage(const char* program)
+{
+    std::cerr << "Usage: " << program
+              << " [-n operands] [-r repetitions] [-s seed] [-j threads] [-o file.json]\n"
+              << "  -n: operands in each generated expression (default 10000)\n"
+              << "  -r: timed repetitions of each stage (default 15)\n"
+              << "  -s: seed for the expression generator (default 1)\n"
+              << "  -j: also time parallel evaluation on this many threads\n"
+              << "  -o: write the results as JSON to this file, or - for the\n"
+              << "      standard output\n";
+}
+
+int main(int argc, char* argv[])
+{
+    Config config;
+    char opts[] = "hn:r:s:j:o:";
+    for (int c; (c = parsing::getopt(argc, argv, opts)) != EOF;)
+        switch (c) {
+        case 'n':
+            config.operands = std::max<std::size_t>(std::strtoull(parsing::optarg, nullptr, 10), 1);
+            break;
+        case 'r':
+            config.repetitions
+                = std::max<std::size_t>(std::strtoull(parsing::optarg, nullptr, 10), 1);
+            break;
+        case 's':
+            config.seed = std::strtoull(parsing::optarg, nullptr, 10);
+            break;
+        case 'j':
+            config.threads = std::strtoull(parsing::optarg, nullptr, 10);
+            break;
+        case 'o':
+            config.json = parsing::optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+
+    std::vector<Result> results;
+    for (auto shape : ExpressionGenerator::shapes())
+        benchmark(config, shape, results);
+
+    // the table goes out of the way when the JSON takes the standard output
+    writeTable(config.json == "-" ? std::cerr : std::cout, results);
+    if (config.json == "-")
+        writeJson(std::cout, config, results);
+    else if (!config.json.empty()) {
+        std::ofstream file(config.json);
+        writeJson(file, config, results);
+        if (!file) {
+            std::cerr << "Can't write " << config.json << '\n';
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,18 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef NULL_BUFFER_H
+#define NULL_BUFFER_H
+
+#include <streambuf>
+
+/**
+ * @class NullBuffer
+ * @brief A stream buffer that discards everything, so output is
+ *        measured without the cost of writing it anywhere.
+ */
+class NullBuffer : public std::streambuf {
+protected:
+    int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+#endif // NULL_BUFFER_H
@@ -0,0 +1,225 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "commands/command.h"
+#include "commands/command_factory.h"
+#include "core/context.h"
+#include "core/getopt.h"
+#include "null_buffer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// What's being replayed, from the command line.
+struct Config {
+    std::string trace;
+    std::size_t passes = 1;
+    double seconds = 0;
+    bool show = false;
+    std::string json;
+};
+
+// One line of the trace and the type of command on it.
+struct Line {
+    std::string text;
+    std::string type;
+};
+
+// The latencies of every command of one type.
+struct Latencies {
+    // Nanoseconds each command took.
+    std::vector<std::uint64_t> samples;
+    // Number of commands that threw.
+    std::size_t errors = 0;
+
+    // Return the q-th quantile (nearest rank) of the sorted samples.
+    [[nodiscard]] std::uint64_t quantile(double q) const
+    {
+        auto rank = static_cast<std::size_t>(std::ceil(q * samples.size()));
+        return samples[std::min(std::max<std::size_t>(rank, 1), samples.size()) - 1];
+    }
+
+    [[nodiscard]] double mean() const
+    {
+        double total = 0;
+        for (auto sample : samples)
+            total += static_cast<double>(sample);
+        return total / samples.size();
+    }
+};
+
+// Read the non-blank lines of a trace, tolerating DOS line endings.
+static std::vector<Line> readTrace(std::istream& in)
+{
+    std::vector<Line> lines;
+    std::string text;
+    while (std::getline(in, text)) {
+        if (!text.empty() && text.back() == '\r')
+            text.pop_back();
+        if (text.empty())
+            continue;
+        lines.push_back({ text, text.substr(0, text.find(' ')) });
+    }
+    return lines;
+}
+
+// Replay the trace once in a fresh Context, as one session would run
+// it, adding each command's latency to its type.
+static void replay(const std::vector<Line>& lines, std::ostream& os,
+    std::map<std::string, Latencies>& latencies)
+{
+    Context context(os);
+    CommandFactory factory(context);
+    for (const auto& line : lines) {
+        auto& stats = latencies[line.type];
+        bool keepGoing = true;
+        auto start = Clock::now();
+        try {
+            keepGoing = factory.makeCommand(line.text).execute();
+        } catch (std::exception&) {
+            ++stats.errors;
+        }
+        auto stop = Clock::now();
+        stats.samples.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+        // quitting ends the session
+        if (!keepGoing)
+            break;
+    }
+    context.output().flush();
+}
+
+static void writeTable(std::ostream& os, const std::map<std::string, Latencies>& latencies,
+    std::size_t commands, std::size_t passes, double elapsed)
+{
+    os << std::fixed << std::setprecision(0) << commands << " commands in " << passes
+       << " passes, " << std::setprecision(3) << elapsed << "s, " << std::setprecision(0)
+       << commands / elapsed << " commands/s\n\n";
+    os << std::left << std::setw(10) << "command" << std::right << std::setw(10) << "count"
+       << std::setw(8) << "errors" << std::setw(11) << "mean us" << std::setw(11) << "p50 us"
+       << std::setw(11) << "p99 us" << std::setw(11) << "p999 us" << std::setw(11) << "max us"
+       << '\n';
+    os << std::setprecision(2);
+    for (const auto& [type, stats] : latencies)
+        os << std::left << std::setw(10) << type << std::right << std::setw(10)
+           << stats.samples.size() << std::setw(8) << stats.errors << std::setw(11)
+           << stats.mean() / 1e3 << std::setw(11) << stats.quantile(0.5) / 1e3 << std::setw(11)
+           << stats.quantile(0.99) / 1e3 << std::setw(11) << stats.quantile(0.999) / 1e3
+           << std::setw(11) << stats.samples.back() / 1e3 << '\n';
+}
+
+static void writeJson(std::ostream& os, const Config& config,
+    const std::map<std::string, Latencies>& latencies, std::size_t commands, std::size_t passes,
+    double elapsed)
+{
+    os << std::fixed << std::setprecision(3);
+    os << "{\n  \"trace\": \"" << config.trace << "\", \"passes\": " << passes
+       << ", \"commands\": " << commands << ", \"seconds\": " << elapsed
+       << ", \"commands_per_second\": " << commands / elapsed << ",\n  \"latency_ns\": {\n";
+    std::size_t i = 0;
+    for (const auto& [type, stats] : latencies) {
+        os << "    \"" << type << "\": {\"count\": " << stats.samples.size()
+           << ", \"errors\": " << stats.errors << ", \"mean\": " << stats.mean()
+           << ", \"p50\": " << stats.quantile(0.5) << ", \"p99\": " << stats.quantile(0.99)
+           << ", \"p999\": " << stats.quantile(0.999) << ", \"max\": " << stats.samples.back()
+           << "}" << (++i < latencies.size() ? ",\n" : "\n");
+    }
+    os << "  }\n}\n";
+}
+
+static void usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [-n passes] [-d seconds] [-p] [-o file.json] trace\n"
+              << "  -n: replay the trace this many times (default 1)\n"
+              << "  -d: keep replaying it for this many seconds instead\n"
+              << "  -p: print the commands' output instead of discarding it\n"
+              << "  -o: write the results as JSON to this file, or - for the\n"
+              << "      standard output\n"
+              << "The trace holds one command per line, as typed in verbose mode;\n"
+              << "every pass runs it in a fresh session.\n";
+}
+
+int main(int argc, char* argv[])
+{
+    Config config;
+    char opts[] = "hn:d:po:";
+    for (int c; (c = parsing::getopt(argc, argv, opts)) != EOF;)
+        switch (c) {
+        case 'n':
+            config.passes = std::max<std::size_t>(std::strtoull(parsing::optarg, nullptr, 10), 1);
+            break;
+        case 'd':
+            config.seconds = std::atof(parsing::optarg);
+            break;
+        case 'p':
+            config.show = true;
+            break;
+        case 'o':
+            config.json = parsing::optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    if (parsing::optind != argc - 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    config.trace = argv[parsing::optind];
+
+    std::ifstream file(config.trace);
+    if (!file) {
+        std::cerr << "Can't open " << config.trace << '\n';
+        return 1;
+    }
+    auto lines = readTrace(file);
+    if (lines.empty()) {
+        std::cerr << config.trace << " has no commands\n";
+        return 1;
+    }
+
+    NullBuffer discard;
+    std::ostream nowhere(&discard);
+    std::ostream& os = config.show ? std::cout : nowhere;
+
+    std::map<std::string, Latencies> latencies;
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double>(config.seconds));
+    std::size_t passes = 0;
+    // some errors are reported straight to std::cerr, so that's
+    // discarded along with the rest of the output
+    auto errors = std::cerr.rdbuf(config.show ? std::cerr.rdbuf() : &discard);
+    do
+        replay(lines, os, latencies);
+    while (++passes < config.passes || (config.seconds > 0 && Clock::now() < deadline));
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cerr.rdbuf(errors);
+
+    std::size_t commands = 0;
+    for (auto& entry : latencies) {
+        std::sort(entry.second.samples.begin(), entry.second.samples.end());
+        commands += entry.second.samples.size();
+    }
+
+    // the table goes out of the way when the JSON takes the standard output
+    writeTable(config.json == "-" ? std::cerr : std::cout, latencies, commands, passes, elapsed);
+    if (config.json == "-")
+        writeJson(std::cout, config, latencies, commands, passes, elapsed);
+    else if (!config.json.empty()) {
+        std::ofstream out(config.json);
+        writeJson(out, config, latencies, commands, passes, elapsed);
+        if (!out) {
+            std::cerr << "Can't write " << config.json << '\n';
+            return 1;
+        }
+    }
+    return 0;
+}
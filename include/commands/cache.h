@@ -0,0 +1,26 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "commands/command_impl.h"
+#include <string>
+
+/**
+ * @class CacheCommand
+ * @brief Prints the expression cache statistics, optionally changing
+ *        its capacity first.
+ */
+class CacheCommand : public Command_Impl {
+public:
+    // Constructor that provides the appropriate Context.
+    explicit CacheCommand(Context&, std::string);
+
+    // Print the cache statistics
+    bool execute() override;
+
+private:
+    // New capacity, or empty to leave it unchanged.
+    std::string capacity;
+};
+
+#endif // CACHE_H
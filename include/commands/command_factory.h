@@ -57,6 +57,24 @@ public:
     // Make the requested list command.
     virtual Command makeHistoryCommand(const std::string& params);
 
+    // Make the requested cache command.
+    virtual Command makeCacheCommand(const std::string& params);
+
+    // Make the requested optimize command.
+    virtual Command makeOptimizeCommand(const std::string& params);
+
+    // Make the requested save command.
+    virtual Command makeSaveCommand(const std::string& params);
+
+    // Make the requested load command.
+    virtual Command makeLoadCommand(const std::string& params);
+
+    // Make the requested stats command.
+    virtual Command makeStatsCommand(const std::string& params);
+
+    // Make the requested trace command.
+    virtual Command makeTraceCommand(const std::string& params);
+
 private:
     // Useful typedefs to simplify use of the STL @std::map.
     typedef Command (CommandFactory::*FACTORY_PTMF)(const std::string&);
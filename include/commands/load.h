@@ -0,0 +1,26 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef LOAD_H
+#define LOAD_H
+
+#include "commands/command_impl.h"
+#include <string>
+
+/**
+ * @class LoadCommand
+ * @brief Maps an archive of expressions, so they're built from it
+ *        instead of being parsed
+ */
+class LoadCommand : public Command_Impl {
+public:
+    // Constructor that provides the appropriate Context.
+    explicit LoadCommand(Context&, std::string);
+
+    // Map the archive
+    bool execute() override;
+
+private:
+    // Path of the archive.
+    std::string path;
+};
+
+#endif // LOAD_H
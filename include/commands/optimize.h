@@ -0,0 +1,21 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef OPTIMIZE_H
+#define OPTIMIZE_H
+
+#include "commands/command_impl.h"
+
+/**
+ * @class OptimizeCommand
+ * @brief Simplifies the current expression tree and reports how many
+ *        nodes were removed.
+ */
+class OptimizeCommand : public Command_Impl {
+public:
+    // Constructor that provides the appropriate Context.
+    explicit OptimizeCommand(Context&);
+
+    // Simplify the tree
+    bool execute() override;
+};
+
+#endif // OPTIMIZE_H
@@ -6,14 +6,15 @@
 
 /**
  * @class QuitCommand
- * @brief Instructs the event loop to shut down.
+ * @brief Ends the session; whoever executes the command sees it return
+ *        false and stops reading commands.
  */
 class QuitCommand : public Command_Impl {
 public:
     // Constructor that provides the appropriate Context.
     explicit QuitCommand(Context&);
 
-    // Quit the event loop.
+    // Say goodbye and return false.
     bool execute() override;
 };
 
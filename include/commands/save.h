@@ -0,0 +1,25 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef SAVE_H
+#define SAVE_H
+
+#include "commands/command_impl.h"
+#include <string>
+
+/**
+ * @class SaveCommand
+ * @brief Writes the cached expressions to an archive file
+ */
+class SaveCommand : public Command_Impl {
+public:
+    // Constructor that provides the appropriate Context.
+    explicit SaveCommand(Context&, std::string);
+
+    // Write the archive
+    bool execute() override;
+
+private:
+    // Path of the archive.
+    std::string path;
+};
+
+#endif // SAVE_H
@@ -0,0 +1,26 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef STATS_H
+#define STATS_H
+
+#include "commands/command_impl.h"
+#include <string>
+
+/**
+ * @class StatsCommand
+ * @brief Prints the latency of each phase of handling a command,
+ *        optionally resetting them afterwards.
+ */
+class StatsCommand : public Command_Impl {
+public:
+    // Constructor that provides the appropriate Context.
+    explicit StatsCommand(Context&, std::string);
+
+    // Print the latency statistics
+    bool execute() override;
+
+private:
+    // "reset" to reset the statistics once printed.
+    std::string action;
+};
+
+#endif // STATS_H
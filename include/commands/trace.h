@@ -0,0 +1,25 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "commands/command_impl.h"
+#include <string>
+
+/**
+ * @class TraceCommand
+ * @brief Writes the trace recorded so far as Chrome trace events.
+ */
+class TraceCommand : public Command_Impl {
+public:
+    // Constructor that provides the appropriate Context.
+    explicit TraceCommand(Context&, std::string);
+
+    // Write the trace
+    bool execute() override;
+
+private:
+    // File to write it to, or empty for the one given with -x.
+    std::string path;
+};
+
+#endif // TRACE_H
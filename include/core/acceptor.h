@@ -0,0 +1,46 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef ACCEPTOR_H
+#define ACCEPTOR_H
+
+#include "core/reactor.h"
+#include <string>
+
+/**
+ * @class Acceptor
+ * @brief Listens on a Unix domain socket and creates an EventHandler,
+ *        with its own Context, for every client that connects.
+ *
+ *        This class plays the role of the "acceptor" in the
+ *        Acceptor-Connector pattern: the Reactor calls it back when a
+ *        connection is pending, and it registers the new connection's
+ *        handler with the Reactor.
+ */
+class Acceptor : public Handler {
+public:
+    // Ctor.  Listens at the designated path, replacing any stale socket
+    // left there.  Clients get verbose handlers if verbose is set, and
+    // are disconnected after idling for idleTimeout unless it's zero.
+    Acceptor(const std::string& path, bool verbose,
+        Reactor::Clock::duration idleTimeout = Reactor::Clock::duration::zero());
+
+    // Dtor.  Stops listening and removes the socket.
+    ~Acceptor() override;
+
+    // Accept a pending connection.
+    void handle() override;
+
+    // Return the listening socket.
+    [[nodiscard]] int descriptor() const override;
+
+private:
+    // Where the socket lives.
+    std::string path;
+    // Do clients get verbose handlers or not?
+    bool verbose;
+    // How long clients may idle for.
+    Reactor::Clock::duration idleTimeout;
+    // The listening socket.
+    int listener;
+};
+
+#endif // ACCEPTOR_H
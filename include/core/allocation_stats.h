@@ -0,0 +1,61 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef ALLOCATION_STATS_H
+#define ALLOCATION_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class AllocationStats
+ * @brief Counts the heap allocations made on each thread.
+ *
+ *        Nothing is counted unless the program is built with the
+ *        TRACK_ALLOCATIONS CMake option, which replaces the global
+ *        operator new and delete with ones that bump thread-local
+ *        counters, and has every Refcounted object count itself.  Taking
+ *        the counts before and after some code says exactly what it
+ *        allocated; LatencyStats does this for every phase of handling a
+ *        command.
+ */
+class AllocationStats {
+public:
+    // Counts for one thread, or the difference between two of them.
+    struct Counts {
+        // calls to operator new
+        std::uint64_t allocations;
+        // bytes asked for by them
+        std::uint64_t bytes;
+        // calls to operator delete
+        std::uint64_t frees;
+        // Refcounted objects constructed
+        std::uint64_t created;
+        // Refcounted objects destroyed
+        std::uint64_t destroyed;
+
+        Counts operator-(const Counts& rhs) const;
+    };
+
+    // Are allocations being counted?
+#ifdef EXPRESSION_TREE_TRACK_ALLOCATIONS
+    static constexpr bool tracking = true;
+#else
+    static constexpr bool tracking = false;
+#endif
+
+    // Return the counts for the calling thread so far.
+    static Counts current();
+
+    // Count an allocation of the designated size.
+    static void allocated(std::size_t bytes);
+
+    // Count a deallocation.
+    static void freed();
+
+    // Count a Refcounted object being constructed.
+    static void created();
+
+    // Count a Refcounted object being destroyed.
+    static void destroyed();
+};
+
+#endif // ALLOCATION_STATS_H
@@ -0,0 +1,52 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef BATCH_PROCESSOR_H
+#define BATCH_PROCESSOR_H
+
+#include "core/context.h"
+#include <istream>
+#include <memory>
+#include <ostream>
+
+class CommandFactory;
+
+/**
+ * @class BatchProcessor
+ * @brief Runs a script of expressions or commands without the
+ *        interactive Reactor.
+ *
+ *        Nothing is prompted for and output is only flushed when the
+ *        stream's buffer fills or the script ends.  By default every
+ *        line is an expression, which is parsed in-order and evaluated
+ *        post-order straight through the Context, just like the macro
+ *        command but without making any Command objects.  In verbose
+ *        mode every line is a command instead, as it would be typed at
+ *        the VerboseHandler's prompt.  Blank lines are skipped, and a
+ *        line that fails is reported along with its line number.
+ */
+class BatchProcessor {
+public:
+    // Ctor.
+    BatchProcessor(std::istream& in, std::ostream& os, bool verbose);
+
+    // Dtor.
+    ~BatchProcessor();
+
+    // Process every line of the script, returning the number of lines
+    // that failed.
+    std::size_t run();
+
+private:
+    // Process a single line, returning false if it was a quit command.
+    bool process(const std::string& line);
+
+    // Where the script is read from.
+    std::istream& in;
+    // Whether lines are commands rather than expressions.
+    bool verbose;
+    // The context where the expression tree state resides.
+    Context context;
+    // A factory for creating commands in verbose mode.
+    std::unique_ptr<CommandFactory> commandFactory;
+};
+
+#endif // BATCH_PROCESSOR_H
@@ -0,0 +1,90 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+/**
+ * @class BoundedQueue
+ * @brief A first-in first-out queue with a fixed capacity that any
+ *        number of threads can push to and pop from.
+ *
+ *        Pushing to a full queue waits for room and popping from an
+ *        empty one waits for an item, so producers can't get ahead of
+ *        the consumers by more than the capacity.  Once the queue is
+ *        closed nothing more can be pushed, and consumers drain what's
+ *        left before popping fails.
+ */
+template <typename T> class BoundedQueue {
+public:
+    // Ctor.
+    explicit BoundedQueue(std::size_t capacity)
+        : capacity(capacity)
+        , closed(false)
+    {
+    }
+
+    // Add an item, waiting while the queue is full.  Returns false if
+    // the queue has been closed.
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        notFull.wait(guard, [this]() { return closed || items.size() < capacity; });
+        if (closed)
+            return false;
+        items.push_back(std::move(item));
+        guard.unlock();
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Remove the oldest item, waiting while the queue is empty.
+    // Returns false once the queue is closed and empty.
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        notEmpty.wait(guard, [this]() { return closed || !items.empty(); });
+        if (items.empty())
+            return false;
+        item = std::move(items.front());
+        items.pop_front();
+        guard.unlock();
+        notFull.notify_one();
+        return true;
+    }
+
+    // Discard every item still waiting and wake producers waiting for
+    // room.
+    void clear()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            items.clear();
+        }
+        notFull.notify_all();
+    }
+
+    // Stop accepting items and wake everyone waiting.
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            closed = true;
+        }
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+
+private:
+    std::mutex lock;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+    std::deque<T> items;
+    std::size_t capacity;
+    bool closed;
+};
+
+#endif // BOUNDED_QUEUE_H
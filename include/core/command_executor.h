@@ -0,0 +1,82 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef COMMAND_EXECUTOR_H
+#define COMMAND_EXECUTOR_H
+
+#include "commands/command.h"
+#include "core/bounded_queue.h"
+#include "core/reactor.h"
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class EventHandler;
+
+/**
+ * @class CommandExecutor
+ * @brief A pool of worker threads that execute commands on behalf of
+ *        the EventHandlers, so a slow command doesn't hold up the
+ *        Reactor or any other session.
+ *
+ *        This class plays the role of the synchronous layer in the
+ *        Half-Sync/Half-Async pattern.  The Reactor's thread reads
+ *        input and makes commands, and submits them through a bounded
+ *        queue; workers execute them; and the results come back to the
+ *        Reactor's thread, which the executor wakes through an eventfd
+ *        it's registered as a handler for.  A session never has more
+ *        than one command submitted at a time, so its commands run in
+ *        order and its Context is only ever used by one thread.
+ */
+class CommandExecutor : public Handler {
+public:
+    // Most commands waiting for a worker at any time.
+    static constexpr std::size_t queueCapacity = 1024;
+
+    // Return the executor, or nullptr if commands run on the Reactor's
+    // thread.
+    static CommandExecutor* instance();
+
+    // Ctor.  Starts the designated number of worker threads.
+    explicit CommandExecutor(std::size_t threads);
+
+    // Dtor.  Finishes the commands already running and stops the
+    // workers; commands still queued are dropped.
+    ~CommandExecutor() override;
+
+    // Queue a command to be executed on behalf of a session.  The
+    // session's completed() is called back on the Reactor's thread once
+    // the command has run.
+    void submit(EventHandler* session, const Command& command);
+
+    // Called back by the Reactor when commands have completed.
+    void handle() override;
+
+    // Return the eventfd workers signal completions through.
+    [[nodiscard]] int descriptor() const override;
+
+private:
+    // A command, who it's for, and how it went.
+    struct Job {
+        EventHandler* session;
+        Command command;
+        bool keepGoing;
+        std::exception_ptr error;
+    };
+
+    // Body of each worker thread.
+    void work();
+
+    // Pointer to the one executor, if any.
+    static CommandExecutor* inst;
+
+    // Commands waiting for a worker.
+    BoundedQueue<Job> jobs;
+    // Commands that have run but haven't been reported yet.
+    std::vector<Job> completed;
+    std::mutex completedLock;
+    // Written by workers to wake the Reactor.
+    int wakeup;
+    std::vector<std::thread> workers;
+};
+
+#endif // COMMAND_EXECUTOR_H
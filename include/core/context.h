@@ -2,8 +2,14 @@
 #ifndef CONTEXT_H
 #define CONTEXT_H
 
+#include "core/expression_cache.h"
 #include "core/state.h"
+#include "tree/incremental_evaluator.h"
+#include "tree/parallel_evaluator.h"
+#include "tree/tree_archive.h"
+#include "tree/variant_tree.h"
 #include "interpreter/variable_map.h"
+#include "output_sink.h"
 #include "tree/expression_tree.h"
 #include <memory>
 #include <queue>
@@ -20,8 +26,10 @@
  */
 class Context {
 public:
-    // Constructor.
-    explicit Context(std::ostream&);
+    // Constructor.  Unless files is set, commands that read or write
+    // files on this machine are refused, as they are for clients
+    // connected over a socket.
+    explicit Context(std::ostream&, bool files = true);
 
     VariableMap& getVariables();
 
@@ -39,6 +47,10 @@ public:
     // format.
     int evaluate(const std::string& format);
 
+    // Simplify the most recently created expression tree, returning the
+    // number of nodes removed.
+    std::size_t optimize();
+
     // Set the value of the variable is a string of the format "variable_name=variable_value"
     void set(const std::string& kvPair);
 
@@ -48,6 +60,28 @@ public:
     // Prints out a list of variables in use
     void list();
 
+    // Prints the expression cache statistics, first setting its capacity
+    // if one is given
+    void cache(const std::string& capacity);
+
+    // Return the cache of parsed expressions.
+    ExpressionCache& expressions();
+    // Write the cached expressions to an archive at the designated path
+    void save(const std::string& path);
+    // Map the archive at the designated path, so the expressions in it
+    // are built from it rather than parsed
+    void load(const std::string& path);
+    // Return the archive mapped by load(), or nullptr if there is none.
+    [[nodiscard]] const TreeArchive* archive() const;
+
+    // Prints the latency of each phase of handling a command, then
+    // resets them if the action is "reset"
+    void stats(const std::string& action);
+
+    // Writes the trace recorded so far to the designated path, or to
+    // the one given with -x (the only one allowed without files)
+    void trace(const std::string& path);
+
     // Return a pointer to the current State.
     [[nodiscard]] State* state() const;
 
@@ -57,14 +91,34 @@ public:
     // Return a reference to the current ExpressionTree.
     ExpressionTree& tree();
 
-    // Set the current ExpressionTree to the newTree.
-    void tree(const ExpressionTree& newTree);
+    // Set the current ExpressionTree to the newTree, along with its
+    // compiled form if that is already known, and the key it is cached
+    // under if it is.
+    void tree(const ExpressionTree& newTree, std::shared_ptr<const Bytecode> program = nullptr,
+        std::string cacheKey = {});
+
+    // Return the current ExpressionTree compiled to Bytecode, compiling
+    // it on first use (and caching the program with the tree).
+    const Bytecode& program();
+
+    // Return the incremental evaluator for the current ExpressionTree,
+    // creating it on first use.
+    IncrementalEvaluator& incremental();
+
+    // Return the current ExpressionTree as a VariantTree, converting it
+    // on first use.
+    const VariantTree& variantTree();
+
+    // Return the parallel evaluator for the current ExpressionTree,
+    // creating it on first use.  It runs on the process-wide
+    // WorkStealingPool.
+    const ParallelEvaluator& parallel();
 
     // Returns whether or not a successful format call has been called
     [[maybe_unused]] [[nodiscard]] bool formatted() const;
 
     // Where all output should be printed
-    [[nodiscard]] std::ostream& output() const;
+    OutputSink& output();
 
     // Returns the history queue
     std::queue<std::string> getHistory();
@@ -85,10 +139,30 @@ private:
     std::unique_ptr<State> treeState;
     // Current expression tree.
     ExpressionTree expTree;
+    // Compiled form of the current expression tree (nullptr until the
+    // tree is first evaluated).
+    std::shared_ptr<const Bytecode> compiled;
+    // Key the current expression tree is cached under, if any.
+    std::string treeKey;
+    // Incremental evaluator for the current expression tree (nullptr
+    // until the tree is first evaluated incrementally).
+    std::unique_ptr<IncrementalEvaluator> incrementalEvaluator;
+    // Current expression tree as a VariantTree (nullptr until first
+    // used).
+    std::unique_ptr<const VariantTree> variants;
+    // Parallel evaluator for the current expression tree (nullptr until
+    // first used).
+    std::unique_ptr<const ParallelEvaluator> parallelEvaluator;
+    // Recently parsed expression trees.
+    ExpressionCache cached;
+    // Archive of expressions, if one was loaded.
+    std::unique_ptr<const TreeArchive> archived;
     // Had the format been set
     bool isFormatted;
+    // Whether commands may read and write files
+    bool files;
     // Where is output being directed
-    std::ostream& os;
+    OutputSink os;
     // Queue keeps track of history
     std::queue<std::string> historyQ;
 };
@@ -0,0 +1,60 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef DESCRIPTOR_STREAM_H
+#define DESCRIPTOR_STREAM_H
+
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+/**
+ * @class DescriptorStream
+ * @brief An output stream to a socket that never waits for the socket.
+ *
+ *        Whatever is written to the stream is queued, and drain() sends
+ *        as much of the queue as the socket takes without blocking, so
+ *        a client that is slow to read can't hold up the thread writing
+ *        to it.  Writing and draining may happen on different threads.
+ *        If the peer has gone away the queued output is dropped rather
+ *        than the process being sent SIGPIPE.
+ */
+class DescriptorStream : public std::ostream {
+public:
+    // Ctor.  The stream doesn't take ownership of the socket.
+    explicit DescriptorStream(int socket);
+
+    // Send as much queued output as the socket takes without blocking.
+    // Returns true once nothing is left queued.
+    bool drain();
+
+    // Return the number of bytes queued.
+    [[nodiscard]] std::size_t backlog();
+
+private:
+    /**
+     * @class Buffer
+     * @brief The stream buffer holding the queue.
+     */
+    class Buffer : public std::streambuf {
+    public:
+        explicit Buffer(int socket);
+
+        bool drain();
+        std::size_t backlog();
+
+    protected:
+        int_type overflow(int_type c) override;
+        std::streamsize xsputn(const char* data, std::streamsize count) override;
+
+    private:
+        int socket;
+        std::mutex lock;
+        // Output queued, of which the first sent bytes have been sent.
+        std::string queued;
+        std::size_t sent;
+    };
+
+    Buffer buffer;
+};
+
+#endif // DESCRIPTOR_STREAM_H
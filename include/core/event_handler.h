@@ -4,7 +4,12 @@
 
 #include "commands/command.h"
 #include "core/context.h"
+#include "core/descriptor_stream.h"
 #include "core/reactor.h"
+#include <deque>
+#include <exception>
+#include <memory>
+#include <string>
 
 class CommandFactory;
 
@@ -17,34 +22,76 @@ class CommandFactory;
  *        pattern and defines methods for use in the Template Method
  *        pattern that is used to process user input commands.
  *
+ *        A handler either serves the user at the standard input, and
+ *        ends the Reactor's event loop when they quit, or serves a
+ *        client connected over a socket, and just closes the connection
+ *        when the client quits.  Either way it has a Context of its
+ *        own, so any number of clients can work independently.  A
+ *        client's Context can't read or write the server's files.
+ *
  * @see   VerboseEventHandler and
  *        MacoEventHandler.
  */
 class EventHandler : public Handler {
 public:
     // Dtor.
-    ~EventHandler() override = default;
+    ~EventHandler() override;
 
     // Factory that creates the appropriate subclass of EventHandler, i.e.,
-    // VerboseHandler or MacroHandler.
+    // VerboseHandler or MacroHandler, to serve the standard input.
     static EventHandler* makeHandler(bool verbose, std::ostream&);
 
+    // Factory that creates the appropriate subclass of EventHandler to
+    // serve a client connected to the designated socket.  The handler
+    // takes ownership of the socket, and closes it if the client idles
+    // for idleTimeout, once its first timer has been scheduled.
+    static EventHandler* makeHandler(bool verbose, int socket,
+        Reactor::Clock::duration idleTimeout = Reactor::Clock::duration::zero());
+
     // This method is called back by the reactor when input is
     // available.  It is a template method that performs the sequence
     // of steps associated with processing expression tree application
-    // commands.
+    // commands for every complete line of input.
     void handle() override;
 
+    // Called back by the reactor when the client socket can take more
+    // of the output queued for it.
+    void handleOutput() override;
+
+    // Called back by the reactor to check whether the client has idled
+    // for too long.
+    void handleTimeout() override;
+
+    // Return the descriptor input is read from.
+    [[nodiscard]] int descriptor() const override;
+
+    // Called back by the CommandExecutor when a command submitted for
+    // this session has run, with what its execution returned or threw.
+    void completed(const Command& command, bool keepGoing, std::exception_ptr error);
+
 protected:
-    // Constructor.
+    // Lines that may be queued before input stops being read.
+    static constexpr std::size_t maxBacklog = 256;
+
+    // Bytes of output that may be queued for a client before its input
+    // stops being read.
+    static constexpr std::size_t maxOutput = 1 << 20;
+
+    friend class CommandExecutor;
+
+    // Constructor for a handler serving the standard input.
     explicit EventHandler(std::ostream&);
 
+    // Constructor for a handler serving a client socket.
+    EventHandler(int socket, Reactor::Clock::duration idleTimeout);
+
     // This hook method is a placeholder for prompting the user for
     // input.
     virtual void promptUser() = 0;
 
-    // This hook method gets user input.
-    virtual bool getInput(std::string&);
+    // This hook method reads whatever input is available, returning
+    // false at the end of the input.
+    virtual bool getInput();
 
     // This hook method is a placeholder for making a command based on
     // the user input.
@@ -53,6 +100,54 @@ protected:
     // This hook method executes a command.
     virtual bool executeCommand(Command command);
 
+    // Make and execute the command for a line of input and prompt for
+    // the next one, returning false if the command was to quit.  With a
+    // CommandExecutor the command is only submitted, and the rest is
+    // done by completed().
+    bool process(const std::string& line);
+
+    // Process queued lines until one is submitted to the
+    // CommandExecutor or there are none left.
+    void runPending();
+
+    // Report the error a command threw.
+    void report(std::exception_ptr error);
+
+    // Send what output the client socket takes, and bring what the
+    // Reactor waits for in line with the session: input while there's
+    // room for more lines and output, and output while some is unsent.
+    // A finished connection is removed once all its output is sent.
+    void update();
+
+    // Stop serving the user or client.
+    void finish();
+
+    // Where input is read from.
+    int input;
+    // Whether input is a client socket rather than the standard input.
+    bool connection;
+    // Input read but not yet split into lines.
+    std::string pending;
+    // Lines waiting to be processed.
+    std::deque<std::string> lines;
+    // Whether a command is with the CommandExecutor.
+    bool busy;
+    // Whether the end of the input has been read.
+    bool ended;
+    // Whether the session is over.
+    bool finished;
+    // Whether the Reactor is waiting for input for us.
+    bool reading;
+    // Whether the Reactor is waiting for the client socket to be writable.
+    bool writing;
+    // How long the client may idle for.
+    Reactor::Clock::duration idleTimeout;
+    // When the client last sent input or got a command's result.
+    Reactor::Clock::time_point lastActive;
+    // Output stream writing to the client socket, if any.
+    std::unique_ptr<DescriptorStream> clientStream;
+    // Where errors are reported.
+    std::ostream& errors;
     // The context where the expression tree state resides.
     Context context;
     // A factory for creating a command.
@@ -73,6 +168,7 @@ protected:
 class VerboseHandler : public EventHandler {
 public:
     explicit VerboseHandler(std::ostream&);
+    VerboseHandler(int socket, Reactor::Clock::duration idleTimeout);
 
 protected:
     // This hook method verbosely prompts the user for input.
@@ -93,6 +189,7 @@ protected:
 class MacroHandler : public EventHandler {
 public:
     explicit MacroHandler(std::ostream&);
+    MacroHandler(int socket, Reactor::Clock::duration idleTimeout);
 
 protected:
     // This hook method less verbosely prompts the user for input.
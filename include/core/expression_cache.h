@@ -0,0 +1,90 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef EXPRESSION_CACHE_H
+#define EXPRESSION_CACHE_H
+
+#include "output_sink.h"
+#include "tree/bytecode.h"
+#include "tree/expression_tree.h"
+#include "tree/tree_archive.h"
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * @class ExpressionCache
+ * @brief A least-recently-used cache of parsed expressions, keyed by
+ *        their normalized text.
+ *
+ *        Trees refer to variables by VariableMap slot and only look
+ *        their values up when evaluated, so a cached tree (and its
+ *        compiled program) stays valid however the variables change.
+ */
+class ExpressionCache {
+public:
+    // What is kept for each expression.
+    struct Entry {
+        // The parsed expression tree.
+        ExpressionTree tree;
+        // The tree compiled to Bytecode (nullptr until it is first
+        // evaluated).
+        std::shared_ptr<const Bytecode> program;
+    };
+
+    // Ctor.
+    explicit ExpressionCache(std::size_t capacity);
+
+    // Return the normalized form of an expression: whitespace is dropped
+    // unless it separates two numbers or names, where it becomes a
+    // single space.
+    static std::string normalize(std::string_view expression);
+
+    // Return the entry for a normalized expression and mark it most
+    // recently used, or return nullptr (and count a miss) if it isn't
+    // cached.
+    const Entry* find(const std::string& key);
+
+    // Add an entry for a normalized expression, evicting the least
+    // recently used entry if the cache is full.
+    void insert(const std::string& key, Entry entry);
+
+    // Keep the compiled form of a tree with its entry, if the tree is
+    // still the one cached under the key.  The entry stays where it is
+    // in the LRU order.
+    void compiled(
+        const std::string& key, const ExpressionTree& tree, std::shared_ptr<const Bytecode> program);
+
+    // Return the maximum number of entries.
+    [[nodiscard]] std::size_t capacity() const;
+
+    // Change the maximum number of entries, evicting as needed.  A
+    // capacity of 0 disables the cache.
+    void capacity(std::size_t capacity);
+
+    // Print the size, capacity and hit/miss counts.
+    void print(OutputSink& os) const;
+
+    // Add every entry to an archive, keyed by its normalized expression,
+    // least recently used first.
+    void save(TreeWriter& writer) const;
+
+private:
+    // Drop least recently used entries until there are at most limit.
+    void evict(std::size_t limit);
+
+    // Entries in order of use, most recent first.
+    using LRU_LIST = std::list<std::pair<std::string, Entry>>;
+    LRU_LIST entries;
+    // Map from normalized expression to its place in entries.
+    std::unordered_map<std::string_view, LRU_LIST::iterator> index;
+    // Maximum number of entries.
+    std::size_t maxEntries;
+    // Number of lookups that found an entry.
+    std::size_t hits;
+    // Number of lookups that didn't.
+    std::size_t misses;
+};
+
+#endif // EXPRESSION_CACHE_H
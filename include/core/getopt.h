@@ -2,6 +2,8 @@
 #ifndef GETOPT_H
 #define GETOPT_H
 
+#include <string>
+
 // Put this into its own namespace to disambiguate from globals.
 namespace parsing {
 extern char* optarg; /* Global argument pointer. */
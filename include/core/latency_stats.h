@@ -0,0 +1,178 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include "core/allocation_stats.h"
+#include "output_sink.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @class LatencyHistogram
+ * @brief Counts latencies in a fixed set of buckets.
+ *
+ *        Buckets are log-linear: each power of two is split into four,
+ *        so a bucket's bounds are within 25% of each other however long
+ *        the latency is, and 256 buckets cover every 64-bit latency.
+ *        Latencies may be in any unit.  Recording is a few relaxed
+ *        atomic operations, so any number of threads can record at once.
+ */
+class LatencyHistogram {
+public:
+    // Ctor.
+    LatencyHistogram();
+
+    // Count a latency.
+    void record(std::uint64_t latency);
+
+    // Return the number of latencies counted.
+    [[nodiscard]] std::uint64_t count() const;
+
+    // Return the mean latency.
+    [[nodiscard]] double mean() const;
+
+    // Return the largest latency.
+    [[nodiscard]] std::uint64_t max() const;
+
+    // Return the upper bound of the bucket holding the q-th quantile.
+    [[nodiscard]] std::uint64_t quantile(double q) const;
+
+    // Forget every latency.
+    void reset();
+
+private:
+    // Sub-buckets per power of two (as a number of bits).
+    static constexpr int subBits = 2;
+    static constexpr std::size_t bucketCount = 64 << subBits;
+
+    // Return the bucket a latency falls in.
+    static std::size_t bucket(std::uint64_t latency);
+
+    // Return the largest latency that falls in a bucket.
+    static std::uint64_t upperBound(std::size_t bucket);
+
+    std::array<std::atomic<std::uint64_t>, bucketCount> buckets;
+    std::atomic<std::uint64_t> sum;
+    std::atomic<std::uint64_t> largest;
+};
+
+/**
+ * @class LatencyStats
+ * @brief Latency histograms for each phase of handling a command, as
+ *        dumped by the stats command.
+ *
+ *        Nothing is measured unless the stats are enabled, which leaves
+ *        a single branch in each Timer.  When they are, a timed phase
+ *        costs two reads of the tick counter and one record().  On x86
+ *        that is the time stamp counter, which is several times cheaper
+ *        to read than the steady clock; ticks are only turned into time
+ *        when the stats are printed, by comparing both clocks since
+ *        enable().  Even so that is comparable to a cheap command, so
+ *        only one run in every so many of each phase need be timed.
+ *
+ *        When allocations are tracked, every run of every phase also
+ *        adds what it allocated to the phase's totals.  A phase's counts
+ *        include those of the phases inside it, so "execute" gives the
+ *        allocations per command.
+ */
+class LatencyStats {
+public:
+    // The phases that are timed.
+    enum class Phase {
+        // reading input (EventHandler::getInput)
+        Input,
+        // making the command for a line (EventHandler::makeCommand)
+        MakeCommand,
+        // executing it (EventHandler::executeCommand)
+        Execute,
+        // prompting for the next one (promptUser)
+        Prompt,
+        // parsing and building a tree (Context::makeTree)
+        MakeTree,
+        // evaluating it (Context::evaluate)
+        Evaluate,
+        // printing it (Context::print)
+        Print,
+        Count
+    };
+
+    /**
+     * @class Timer
+     * @brief Times a phase from construction to destruction.
+     */
+    class Timer {
+    public:
+        explicit Timer(Phase phase);
+        ~Timer();
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+    private:
+        Phase phase;
+        bool timing;
+        std::uint64_t start;
+        // Counts when the phase started, if allocations are tracked.
+        AllocationStats::Counts allocations;
+    };
+
+    // Singleton access point.
+    static LatencyStats* instance();
+
+    // Dtor.
+    ~LatencyStats();
+
+    // Time one run in every of each phase (0 to time none).
+    void enable(std::size_t every);
+
+    // Return whether phases are being measured.
+    [[nodiscard]] bool enabled() const;
+
+    // Return the current tick count.
+    static std::uint64_t ticks();
+
+    // Count the latency of a phase, in ticks.
+    void record(Phase phase, std::uint64_t latency);
+
+    // Add what one run of a phase allocated.
+    void record(Phase phase, const AllocationStats::Counts& allocated);
+
+    // Print a line for every phase that has been measured.
+    void print(OutputSink& os) const;
+
+    // Forget every latency.
+    void reset();
+
+private:
+    // Constructor is private to ensure use as a singleton.
+    LatencyStats();
+
+    // Decide whether to time this run of a phase.
+    bool sample(Phase phase) const;
+
+    // What the runs of one phase have allocated, in total.
+    struct Allocations {
+        std::atomic<std::uint64_t> runs;
+        std::atomic<std::uint64_t> allocations;
+        std::atomic<std::uint64_t> bytes;
+        std::atomic<std::uint64_t> created;
+    };
+
+    // Print what each phase allocates per run.
+    void printAllocations(OutputSink& os) const;
+
+    // Pointer to the singleton instance.
+    static LatencyStats* inst;
+
+    std::array<LatencyHistogram, static_cast<std::size_t>(Phase::Count)> histograms;
+    std::array<Allocations, static_cast<std::size_t>(Phase::Count)> allocated;
+    // Time one run in this many (0 for none).
+    std::atomic<std::uint32_t> sampling;
+    // Both clocks when measuring started, to convert ticks to time.
+    std::uint64_t startTicks;
+    std::chrono::steady_clock::time_point startTime;
+};
+
+#endif // LATENCY_STATS_H
@@ -31,6 +31,52 @@ public:
     // Run the program in verbose mode.
     [[nodiscard]] bool verbose() const;
 
+    // Build expression trees in a single FlatTree arena.
+    [[nodiscard]] bool arena() const;
+
+    // Parse expressions with the single-pass PrattParser.
+    [[nodiscard]] bool pratt() const;
+
+    // Share the nodes of repeated subexpressions.
+    [[nodiscard]] bool share() const;
+
+    // Simplify every expression as it is parsed.
+    [[nodiscard]] bool optimize() const;
+
+    // Re-evaluate expressions incrementally after variables change.
+    [[nodiscard]] bool incremental() const;
+
+    // Evaluate and print expressions through a VariantTree.
+    [[nodiscard]] bool variant() const;
+
+    // Time one run in this many of each phase of handling a command, for
+    // the stats command (0 to time none).
+    [[nodiscard]] std::size_t stats() const;
+
+    // Number of threads used to evaluate large expressions (0 to
+    // evaluate them on the calling thread only).
+    [[nodiscard]] std::size_t threads() const;
+
+    // Path of the script to run instead of prompting for input ("-" for
+    // the standard input, empty to run interactively).
+    [[nodiscard]] const std::string& script() const;
+
+    // Path of the Unix domain socket to serve clients on instead of
+    // prompting for input (empty to run interactively).
+    [[nodiscard]] const std::string& server() const;
+
+    // Number of worker threads that execute commands (0 to execute them
+    // on the Reactor's thread).
+    [[nodiscard]] std::size_t workers() const;
+
+    // Seconds a client may idle for before it's disconnected (0 to let
+    // clients idle forever).
+    [[nodiscard]] std::size_t idleTimeout() const;
+
+    // Path of the file a trace of every command is written to on exit
+    // (empty to not trace them).
+    [[nodiscard]] const std::string& trace() const;
+
     // Parse command-line arguments and set the appropriate values as
     // follows:
     // 't' - Traversal strategy, i.e., 'P' for pre-order, 'O' for
@@ -49,6 +95,32 @@ private:
     std::string pathStr;
     // Are we running in verbose mode or not?
     bool isVerbose;
+    // Are expression trees built in a FlatTree arena or not?
+    bool useArena;
+    // Are expressions parsed by the PrattParser or not?
+    bool usePratt;
+    // Are repeated subexpressions shared or not?
+    bool useSharing;
+    // Are expressions simplified when parsed or not?
+    bool useOptimizer;
+    // Are expressions re-evaluated incrementally or not?
+    bool useIncremental;
+    // Are expressions evaluated and printed through a VariantTree or not?
+    bool useVariant;
+    // How many threads evaluate large expressions?
+    std::size_t threadCount;
+    // Script to run, if any.
+    std::string scriptPath;
+    // Socket to serve clients on, if any.
+    std::string socketPath;
+    // How many threads execute commands?
+    std::size_t workerCount;
+    // How long may clients idle for?
+    std::size_t idleSeconds;
+    // How often are latencies recorded?
+    std::size_t statsEvery;
+    // File to write a trace to, if any.
+    std::string tracePath;
 
     // Pointer to the singleton Options instance.
     static Options* inst;
@@ -2,6 +2,10 @@
 #ifndef REACTOR_H
 #define REACTOR_H
 
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
 #include <vector>
 
 /**
@@ -18,6 +22,17 @@ public:
 
     // Called back by the Reactor when input events occur.
     virtual void handle() = 0;
+
+    // Called back by the Reactor when the handler's descriptor can be
+    // written to, if the handler asked to be told.
+    virtual void handleOutput() { }
+
+    // Called back by the Reactor when a timer scheduled for the handler
+    // is due.
+    virtual void handleTimeout() { }
+
+    // Return the I/O handle the handler waits for input on.
+    [[nodiscard]] virtual int descriptor() const = 0;
 };
 
 /**
@@ -28,37 +43,111 @@ public:
  *        This class plays the role of the "reactor" in the
  *        Reactor pattern.  It is access as a singleton and uses the
  *        Iterator pattern to dispatch the various event handlers.
+ *
+ *        The event loop sleeps in epoll until at least one handler's
+ *        descriptor is readable and then dispatches just those
+ *        handlers.  Descriptors epoll can't wait on (regular files, as
+ *        when the input is redirected from one) are always readable, so
+ *        their handlers are dispatched on every pass instead.  A handler
+ *        with output the descriptor couldn't take yet can also ask to
+ *        be called back once it's writable.  Timers are kept in order of
+ *        when they're due, and epoll only sleeps until the earliest one,
+ *        so a process with nothing to do uses no CPU at all.
  */
 class Reactor {
 public:
+    // The clock timers are measured by.
+    using Clock = std::chrono::steady_clock;
+
     // Singleton access point.
     static Reactor* instance();
 
     // Dtor.
     ~Reactor();
 
-    // Run the reactor's event loop.
+    // Run the reactor's event loop until it's ended or there are no
+    // handlers left.
     void runEventLoop();
 
     // End the reactor's event loop.
     void endEventLoop();
 
-    // Register event_handler for input events.
+    // Register event_handler for input events.  The reactor takes
+    // ownership of the handler.
     void registerHandler(Handler* handler);
 
-    // Remove event_handler for input events.
+    // Remove event_handler for input events.  The handler is deleted
+    // once the current round of dispatching is over, so a handler may
+    // remove itself.
     void removeHandler(Handler* handler);
 
+    // Stop dispatching a handler until it's resumed, e.g. while it has
+    // more input queued than it can keep up with.
+    void suspendHandler(Handler* handler);
+
+    // Dispatch a suspended handler again.
+    void resumeHandler(Handler* handler);
+
+    // Start or stop calling a handler back when its descriptor is
+    // writable.
+    void watchOutput(Handler* handler, bool on);
+
+    // Call a handler's handleTimeout() once delay has passed, and then
+    // every interval after that unless interval is zero.
+    void scheduleTimer(Handler* handler, Clock::duration delay,
+        Clock::duration interval = Clock::duration::zero());
+
+    // Cancel all the timers scheduled for a handler.
+    void cancelTimers(Handler* handler);
+
 private:
     // Constructor is private to ensure use as a singleton.
     Reactor();
 
+    // Change the epoll events a handler's descriptor is waited for.
+    void watch(Handler* handler, std::uint32_t events);
+
+    // Dispatch a handler's input or output events unless it was removed
+    // earlier in this round.
+    void dispatch(Handler* handler, std::uint32_t events);
+
+    // Delete the handlers removed during the last round.
+    void reap();
+
+    // Return how many milliseconds epoll may sleep for before the next
+    // timer is due (-1 if there are none).
+    [[nodiscard]] int timeout() const;
+
+    // Dispatch the handlers whose timers are due.
+    void expire();
+
+    // A scheduled timer: who's called back, and how often.
+    struct Timer {
+        Handler* handler;
+        Clock::duration interval;
+    };
+
     // Pointer to the singleton instance of the Reactor.
     static Reactor* inst;
 
     // Vector of pointers to Event_Handler objects used to dispatch callbacks.
     std::vector<Handler*> dispatchTable;
 
+    // The epoll events each handler's descriptor is waited for.
+    std::unordered_map<Handler*, std::uint32_t> interest;
+
+    // Handlers whose descriptors can't be waited on.
+    std::vector<Handler*> alwaysReady;
+
+    // Timers, in the order they're due.
+    std::multimap<Clock::time_point, Timer> timers;
+
+    // Handlers removed but not yet deleted.
+    std::vector<Handler*> removed;
+
+    // The epoll instance used to wait for input.
+    int poller;
+
     // Keeps track of whether we're running the event loop or not.
     bool runningEventLoop;
 };
@@ -0,0 +1,39 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef SIGNAL_HANDLER_H
+#define SIGNAL_HANDLER_H
+
+#include "core/reactor.h"
+
+/**
+ * @class SignalHandler
+ * @brief Ends the Reactor's event loop when the process is asked to
+ *        terminate (SIGINT or SIGTERM).
+ *
+ *        The signals are blocked and read from a signalfd, so they
+ *        arrive as ordinary input events on the Reactor's thread rather
+ *        than interrupting whatever is running.  The event loop then
+ *        returns normally and every handler is destroyed as usual, e.g.
+ *        so an Acceptor removes its socket.  It has to be created before
+ *        any other thread, which would otherwise still take the signals.
+ *        They stay blocked until the process exits.
+ */
+class SignalHandler : public Handler {
+public:
+    // Ctor.  Blocks the signals and starts reading them.
+    SignalHandler();
+
+    // Dtor.
+    ~SignalHandler() override;
+
+    // Read the pending signal and end the event loop.
+    void handle() override;
+
+    // Return the signalfd.
+    [[nodiscard]] int descriptor() const override;
+
+private:
+    // The signalfd the signals are read from.
+    int signals;
+};
+
+#endif // SIGNAL_HANDLER_H
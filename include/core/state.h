@@ -2,6 +2,7 @@
 #ifndef STATE_H
 #define STATE_H
 
+#include "output_sink.h"
 #include <iostream>
 #include <map>
 #include <string>
@@ -48,23 +49,27 @@ public:
     // Print the most recently created expression tree using the
     // designated format, updating the state of the @context
     // accordingly.
-    virtual void print(const std::string& format, std::ostream& os) = 0;
+    virtual void print(const std::string& format, OutputSink& os) = 0;
 
     // Evaluate the "yield" of the most recently created expression
     // tree using the designated format, updating the state of the
     // @context accordingly.
     virtual int evaluate(const std::string& format) = 0;
 
+    // Simplify the most recently created expression tree, returning
+    // the number of nodes removed.
+    virtual std::size_t optimize() = 0;
+
     // Print the appropriate commands that are available to the user
     virtual void printValidCommands() const = 0;
 
 protected:
-    // Print the tree in the designated traversal_order.
-    static void printTree(const ExpressionTree& tree, const std::string& order, std::ostream& os);
+    // Print the context's tree in the designated traversal_order.
+    static void printTree(Context& context, const std::string& order, OutputSink& os);
 
-    // Evaluate and print the yield of the tree to the @os in the
-    // designated traversal_order.
-    static auto evaluateTree(const ExpressionTree& tree, const std::string& order);
+    // Evaluate the yield of the context's tree in the designated
+    // traversal_order.
+    static int evaluateTree(Context& context, const std::string& order);
 
     Context& context;
 };
@@ -91,13 +96,17 @@ public:
     // Print the most recently created expression tree using the
     // designated format, updating the state of the @context
     // accordingly.
-    void print(const std::string& format, std::ostream& os) override;
+    void print(const std::string& format, OutputSink& os) override;
 
     // Evaluate the "yield" of the most recently created expression
     // tree using the designated format, updating the state of the
     // @context accordingly.
     int evaluate(const std::string& format) override;
 
+    // Simplify the most recently created expression tree, updating the
+    // state of the @context accordingly.
+    std::size_t optimize() override;
+
     // Print the list of valid command if the user is in this state
     void printValidCommands() const override;
 
@@ -171,7 +180,7 @@ public:
     explicit PreOrderInitializedState(Context& ctx);
 
     // Print the current expression tree in the context using the designed format.
-    void print(const std::string& format, std::ostream& os) override;
+    void print(const std::string& format, OutputSink& os) override;
 
     // Evaluate the yield of the current expression tree in the context using the designed format.
     int evaluate(const std::string& format) override;
@@ -204,7 +213,7 @@ public:
 
     // Print the current expression tree in the context using the
     // designed format.
-    void print(const std::string& format, std::ostream& os) override;
+    void print(const std::string& format, OutputSink& os) override;
 
     // Evaluate the yield of the current expression tree in the @a
     // context using the designed format.
@@ -241,12 +250,15 @@ public:
 
     // Print the current expression tree in the context using the
     // designed format.
-    void print(const std::string& format, std::ostream& os) override;
+    void print(const std::string& format, OutputSink& os) override;
 
     // Evaluate the yield of the current expression tree in the @a
     // context using the designed format.
     int evaluate(const std::string& format) override;
 
+    // Simplify the current expression tree in the context.
+    std::size_t optimize() override;
+
     // Print the list of valid command if the user is in this state
     void printValidCommands() const override;
 };
@@ -278,7 +290,7 @@ public:
 
     // Print the current expression tree in the context using the
     // designed format.
-    void print(const std::string& format, std::ostream& os) override;
+    void print(const std::string& format, OutputSink& os) override;
 
     // Evaluate the yield of the current expression tree in the @a
     // context using the designed format.
@@ -0,0 +1,104 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @class Tracer
+ * @brief Records a timeline of spans, such as commands and the parses,
+ *        builds, traversals and visitor passes they run, and writes it
+ *        out as Chrome trace events.
+ *
+ *        Spans are kept in a ring buffer of fixed size, so a long-running
+ *        server keeps only the most recent ones.  Load the output in
+ *        chrome://tracing or Perfetto to see where the time goes.
+ *        Nothing is recorded unless tracing is enabled, which leaves a
+ *        single branch in each Span.
+ */
+class Tracer {
+public:
+    /**
+     * @class Span
+     * @brief Records a span from construction to destruction.
+     */
+    class Span {
+    public:
+        // Ctor.  The name and category must be string literals.
+        Span(const char* name, const char* category);
+        ~Span();
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+        // Show a count, e.g. of the nodes visited, with the span.
+        void count(const char* what, std::int64_t value);
+
+    private:
+        const char* name;
+        const char* category;
+        bool tracing;
+        std::chrono::steady_clock::time_point start;
+        const char* what;
+        std::int64_t value;
+    };
+
+    // Singleton access point.
+    static Tracer* instance();
+
+    // Dtor.
+    ~Tracer();
+
+    // Start recording, keeping the designated number of most recent spans.
+    void enable(std::size_t capacity);
+
+    // Return whether spans are being recorded.
+    [[nodiscard]] bool enabled() const;
+
+    // Write the recorded spans as a Chrome trace, returning how many
+    // there were.
+    std::size_t write(std::ostream& os) const;
+
+    // Write the recorded spans to a file, returning how many there were.
+    std::size_t write(const std::string& path) const;
+
+private:
+    // A completed span.
+    struct Event {
+        const char* name;
+        const char* category;
+        // start and duration, in nanoseconds since the tracer was enabled
+        std::int64_t start;
+        std::int64_t duration;
+        std::uint32_t thread;
+        // the span's count, if what isn't nullptr
+        const char* what;
+        std::int64_t value;
+    };
+
+    // Constructor is private to ensure use as a singleton.
+    Tracer();
+
+    // Add a completed span to the ring buffer.
+    void record(const Event& event);
+
+    // Pointer to the singleton instance.
+    static Tracer* inst;
+
+    std::atomic<bool> tracing;
+    // When tracing started; every timestamp is relative to this.
+    std::chrono::steady_clock::time_point epoch;
+    // Guards the ring buffer, which spans may be added to from any thread.
+    mutable std::mutex lock;
+    std::vector<Event> events;
+    // Number of spans ever recorded; the next goes in events[recorded % size].
+    std::uint64_t recorded;
+};
+
+#endif // TRACER_H
@@ -0,0 +1,119 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class WorkStealingPool
+ * @brief A fixed set of worker threads that run fork/join tasks.
+ *
+ *        Every worker has its own deque of tasks.  A worker pushes the
+ *        tasks it forks onto the back of its own deque and takes work
+ *        from the back as well, so it keeps working on the most recently
+ *        split (and so most cache-friendly) piece of a problem.  An idle
+ *        worker steals from the front of another worker's deque, which
+ *        holds the oldest and therefore largest pieces.  Threads outside
+ *        the pool fork onto a shared deque that every worker steals from.
+ *
+ *        Joining a task that hasn't finished yet doesn't block: the
+ *        joining thread runs other queued tasks until it has, so nested
+ *        forks can never deadlock the pool.
+ */
+class WorkStealingPool {
+public:
+    /**
+     * @class Task
+     * @brief A unit of work forked onto the pool.  A Task is owned by
+     *        whoever forks it and must outlive the matching join().
+     */
+    class Task {
+    public:
+        // Ctor.
+        explicit Task(std::function<void()> work);
+
+    private:
+        friend class WorkStealingPool;
+
+        // Run the work, catching any exception for join() to rethrow.
+        void run();
+
+        std::function<void()> work;
+        std::atomic<bool> finished;
+        std::exception_ptr error;
+    };
+
+    // Ctor.  Starts the designated number of worker threads.
+    explicit WorkStealingPool(std::size_t threads);
+
+    // Dtor.  Stops and joins the workers; every forked task must have
+    // been joined already.
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Return the pool shared by every session in the process, or
+    // nullptr if there is none.
+    static WorkStealingPool* instance();
+
+    // Make the designated pool the one shared by every session.  It
+    // stops being shared when it's destroyed.
+    static void instance(WorkStealingPool* pool);
+
+    // Return the number of worker threads.
+    [[nodiscard]] std::size_t size() const;
+
+    // Queue a task to be run by some thread in the pool.
+    void fork(Task& task);
+
+    // Wait for a forked task to finish, running other tasks meanwhile,
+    // and rethrow any exception it threw.
+    void join(Task& task);
+
+private:
+    // A deque of tasks and the lock guarding it.
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task*> tasks;
+    };
+
+    // Body of each worker thread.
+    void work(std::size_t self);
+
+    // Take a task from the designated queue, from its back if it's the
+    // caller's own queue and from its front otherwise.
+    Task* take(std::size_t queue, bool own);
+
+    // Find a task to run, looking at the caller's own queue first and
+    // then stealing from the others.  Returns nullptr if there is none.
+    Task* find(std::size_t self);
+
+    // Index of the queue owned by the calling thread; threads outside the
+    // pool share the last queue.
+    [[nodiscard]] std::size_t self() const;
+
+    // Pointer to the shared pool, if any.
+    static WorkStealingPool* inst;
+
+    // One queue per worker, plus the shared one for outside threads.
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    // Number of tasks waiting in the queues.
+    std::atomic<std::size_t> queued;
+    // Set when the pool is shutting down.
+    std::atomic<bool> stopping;
+    // Idle workers sleep on this until there's something to steal.
+    std::mutex idleLock;
+    std::condition_variable idle;
+};
+
+#endif // WORK_STEALING_POOL_H
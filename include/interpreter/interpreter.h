@@ -2,9 +2,10 @@
 #ifndef INTERPRETER_H
 #define INTERPRETER_H
 
+#include "interpreter/lexer.h"
 #include "tree/expression_tree.h"
 #include <list>
-#include <string>
+#include <string_view>
 #include <unordered_map>
 
 // Forward declaration.
@@ -27,35 +28,41 @@ public:
 
     // Converts a string and variables into a parse tree, and builds an
     // expression tree out of the parse tree.
-    static ExpressionTree interpret(const VariableMap& vars, const std::string& input);
+    static ExpressionTree interpret(VariableMap& vars, std::string_view input);
+
+    // Converts a string and variables into a parse tree, and builds an
+    // expression tree whose nodes all live in a single FlatTree arena.
+    // If share is set, repeated subexpressions share their nodes.
+    static ExpressionTree interpretFlat(
+        VariableMap& vars, std::string_view input, bool share = false);
+
+    // Converts a string and variables into a parse tree, leaving the
+    // root symbol at the back of the list.  The caller owns the root
+    // symbol, which owns the rest of the parse tree.
+    static void parse(VariableMap& vars, std::string_view input, std::list<Symbol*>& list);
 
 private:
+
     // Method for checking if a character is a valid operator.
     [[maybe_unused]] static bool isOperator(char input);
-    // Method for checking if a character is a number.
-    static bool isNumber(char input);
-    // Method for checking if a character is part of a variable name.
-    static bool isAlphanumeric(char input);
 
     // Inserts a terminal into the parse tree.
     [[maybe_unused]] static void terminalInsert(Symbol* op, std::list<Symbol*>& list);
     // Inserts a variable (leaf node / number) into the parse tree.
-    static void variableInsert(const VariableMap& varsa, const std::string& input,
-        std::string::size_type& i, int& accumulated_precedence, std::list<Symbol*>& list,
-        Symbol*& lastValidInput);
+    static void variableInsert(VariableMap& varsa, const Lexer::Token& token,
+        int& accumulated_precedence, std::list<Symbol*>& list, Symbol*& lastValidInput);
     // Inserts a leaf node / number into the parse tree.
-    static void numberInsert(const std::string& input, std::string::size_type& i,
-        int& accumulatedPrecedence, std::list<Symbol*>& list, Symbol*& lastValidInput);
+    static void numberInsert(const Lexer::Token& token, int& accumulatedPrecedence,
+        std::list<Symbol*>& list, Symbol*& lastValidInput);
     // Inserts a multiplication or division into the parse tree.
     static void precedenceInsert(Symbol* op, std::list<Symbol*>& list);
     // Process parenthesized expressions properly.
-    static void handleParenthesis(const VariableMap& vars, const std::string& input,
-        std::string::size_type& i, Symbol*& lastValidInput, bool& handled,
-        int& accumulatedPrecedence, std::list<Symbol*>& list);
+    static void handleParenthesis(VariableMap& vars, Lexer& lexer, Symbol*& lastValidInput,
+        bool& handled, int& accumulatedPrecedence, std::list<Symbol*>& list);
 
     // Main interpreter loop.
-    static void mainLoop(const VariableMap&, const std::string&, std::string::size_type& i,
-        Symbol*&, bool&, int&, std::list<Symbol*>&);
+    static void mainLoop(VariableMap&, const Lexer::Token&, Lexer&, Symbol*&, bool&, int&,
+        std::list<Symbol*>&);
 };
 
 #endif // INTERPRETER_H
@@ -0,0 +1,57 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <string_view>
+
+/**
+ * @class Lexer
+ * @brief Splits an expression string into tokens for the parsers.
+ *
+ *        Tokens are slices of the input rather than copies of it, and
+ *        numbers are converted in place with std::from_chars, so lexing
+ *        doesn't allocate.  The input must outlive the tokens.
+ */
+class Lexer {
+public:
+    // A single token of the input.
+    struct Token {
+        // The kind of token.
+        enum class Kind {
+            // No input is left.
+            End,
+            // A run of digits; value holds the number.
+            Number,
+            // A letter followed by letters and digits.
+            Identifier,
+            // Any other single character, e.g., an operator or parenthesis.
+            Operator
+        };
+
+        Kind kind;
+        // The characters of the input the token was read from.
+        std::string_view text;
+        // The value of a Number token.
+        int value;
+    };
+
+    // Ctor.
+    explicit Lexer(std::string_view input);
+
+    // Return the next token, skipping whitespace.  Throws
+    // std::invalid_argument if a number doesn't fit in an int.
+    Token next();
+
+    // Method for checking if a character is a number.
+    static bool isNumber(char input);
+    // Method for checking if a character is part of a variable name.
+    static bool isAlphanumeric(char input);
+
+private:
+    // The input being split.
+    std::string_view input;
+    // Position of the next unread character.
+    std::string_view::size_type position;
+};
+
+#endif // LEXER_H
@@ -0,0 +1,56 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef PRATT_PARSER_H
+#define PRATT_PARSER_H
+
+#include "tree/expression_tree.h"
+#include "tree/flat_tree.h"
+#include <string_view>
+#include <vector>
+
+// Forward declaration.
+class VariableMap;
+
+/**
+ * @class PrattParser
+ * @brief Parses incoming expression strings straight into a FlatTree in
+ *        a single left-to-right pass.
+ *
+ *        Unlike Interpreter, no intermediate parse tree of Symbols is
+ *        built.  Operands are appended to the FlatTree as soon as they
+ *        are read and pending operators wait on an explicit stack until
+ *        an operator of lower or equal precedence (or a closing
+ *        parenthesis) reduces them, so each token is handled a constant
+ *        number of times.  Operator precedence and associativity match
+ *        those of Interpreter, except that a closing parenthesis
+ *        without a matching open one throws std::invalid_argument,
+ *        where Interpreter ignores it.
+ */
+class PrattParser {
+public:
+    // Only static usage - no constructor.
+    PrattParser() = delete;
+
+    // Converts a string and variables into a FlatTree-backed expression
+    // tree.  If share is set, repeated subexpressions share their nodes.
+    static ExpressionTree parse(VariableMap& vars, std::string_view input, bool share = false);
+
+private:
+    // An operator waiting on the operator stack.
+    struct PendingOperator {
+        // Opcode of the node to build, or Number for an open parenthesis.
+        FlatTree::Opcode opcode;
+        // Precedence of the operator.
+        int precedence;
+    };
+
+    // Look up the binary operator for a character, returning false if the
+    // character is not a binary operator.
+    static bool binaryOperator(char input, FlatTree::Opcode& opcode, int& precedence);
+
+    // Pop the top operator off the stack and build its node from the
+    // operands on top of the operand stack.
+    static void reduce(FlatTree& tree, std::vector<PendingOperator>& operators,
+        std::vector<FlatTree::Index>& operands);
+};
+
+#endif // PRATT_PARSER_H
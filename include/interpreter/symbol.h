@@ -2,7 +2,9 @@
 #ifndef SYMBOL_H
 #define SYMBOL_H
 
+#include "tree/flat_tree.h"
 #include <string>
+#include <string_view>
 
 // Class Predeclarations
 class ComponentNode;
@@ -26,6 +28,9 @@ public:
     virtual int addPrecedence(int accumulatedPrecedence) = 0;
     // abstract method for building an Expression ExpressionTree Node
     virtual ComponentNode* build() = 0;
+    // abstract method for building the node into a FlatTree, returning
+    // its index
+    virtual FlatTree::Index build(FlatTree& tree) = 0;
     // left and right pointers
     Symbol* left;
     Symbol* right;
@@ -77,8 +82,7 @@ public:
  */
 class Number : public Symbol {
 public:
-    // constructors
-    explicit Number(const std::string& input);
+    // constructor
     explicit Number(const int& input);
     // destructor
     ~Number() override = default;
@@ -86,12 +90,38 @@ public:
     int addPrecedence(int accumulatedPrecedence) override;
     // builds an equivalent ExpressionTree node
     ComponentNode* build() override;
+    // builds an equivalent node in the FlatTree
+    FlatTree::Index build(FlatTree& tree) override;
 
 private:
     // contains the value of the leaf node
     int item;
 };
 
+/**
+ * @class Variable
+ * @brief Leaf node of parse tree that refers to a variable
+ */
+class Variable : public Symbol {
+public:
+    // constructor
+    Variable(std::string_view name, int slot);
+    // destructor
+    ~Variable() override = default;
+    // returns the precedence level
+    int addPrecedence(int accumulatedPrecedence) override;
+    // builds an equivalent ExpressionTree node
+    ComponentNode* build() override;
+    // builds an equivalent node in the FlatTree
+    FlatTree::Index build(FlatTree& tree) override;
+
+private:
+    // name of the variable, a slice of the parsed input
+    std::string_view name;
+    // slot of the variable in the VariableMap
+    int slot;
+};
+
 /**
  * @class Subtract
  * @brief Subtraction node of the parse tree
@@ -106,6 +136,8 @@ public:
     int addPrecedence(int accumulatedPrecedence) override;
     // builds an equivalent ExpressionTree node
     ComponentNode* build() override;
+    // builds an equivalent node in the FlatTree
+    FlatTree::Index build(FlatTree& tree) override;
 };
 
 /**
@@ -122,6 +154,8 @@ public:
     int addPrecedence(int accumulatedPrecedence) override;
     // builds an equivalent Expression_Tree node
     ComponentNode* build() override;
+    // builds an equivalent node in the FlatTree
+    FlatTree::Index build(FlatTree& tree) override;
 };
 
 /**
@@ -138,6 +172,8 @@ public:
     int addPrecedence(int accumulatedPrecedence) override;
     // builds an equivalent ExpressionTree node
     ComponentNode* build() override;
+    // builds an equivalent node in the FlatTree
+    FlatTree::Index build(FlatTree& tree) override;
 };
 
 /**
@@ -154,6 +190,8 @@ public:
     int addPrecedence(int accumulatedPrecedence) override;
     // builds an equivalent Expression_Tree node
     ComponentNode* build() override;
+    // builds an equivalent node in the FlatTree
+    FlatTree::Index build(FlatTree& tree) override;
 };
 
 /**
@@ -170,6 +208,8 @@ public:
     int addPrecedence(int accumulatedPrecedence) override;
     // builds an equivalent Expression_Tree node
     ComponentNode* build() override;
+    // builds an equivalent node in the FlatTree
+    FlatTree::Index build(FlatTree& tree) override;
 };
 
 class Exponent : public Operator {
@@ -182,6 +222,8 @@ public:
     int addPrecedence(int accumulatedPrecedence) override;
     // builds an equivalent Expression_Tree node
     ComponentNode* build() override;
+    // builds an equivalent node in the FlatTree
+    FlatTree::Index build(FlatTree& tree) override;
 };
 
 class Modulus : public Operator {
@@ -194,6 +236,8 @@ public:
     int addPrecedence(int accumulatedPrecedence) override;
     // builds an equivalent Expression_Tree node
     ComponentNode* build() override;
+    // builds an equivalent node in the FlatTree
+    FlatTree::Index build(FlatTree& tree) override;
 };
 
 class Factorial : public LeftUnaryOperator {
@@ -206,6 +250,8 @@ public:
     int addPrecedence(int accumulatedPrecedence) override;
     // builds an equivalent ExpressionTree node
     ComponentNode* build() override;
+    // builds an equivalent node in the FlatTree
+    FlatTree::Index build(FlatTree& tree) override;
 };
 
 class Ceiling : public Operator {
@@ -218,6 +264,8 @@ public:
     int addPrecedence(int accumulatedPrecedence) override;
     // builds an equivalent Expression_Tree node
     ComponentNode* build() override;
+    // builds an equivalent node in the FlatTree
+    FlatTree::Index build(FlatTree& tree) override;
 };
 
 class Floor : public Operator {
@@ -230,6 +278,8 @@ public:
     int addPrecedence(int accumulatedPrecedence) override;
     // builds an equivalent Expression_Tree node
     ComponentNode* build() override;
+    // builds an equivalent node in the FlatTree
+    FlatTree::Index build(FlatTree& tree) override;
 };
 
 #endif // SYMBOL_H
@@ -2,34 +2,72 @@
 #ifndef VARIABLE_MAP
 #define VARIABLE_MAP
 
+#include "output_sink.h"
+#include <deque>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 /***
  * @class VariableMap
  * @brief This class stores variables and their values for use by the Interpreters.
  *        This class plays the role of the "context" in the Interpreter pattern.
+ *
+ *        Each variable name is interned to an integer slot the first time
+ *        it is seen, so expression trees can refer to variables by slot
+ *        and look their values up by array index when evaluated.
  */
 class VariableMap {
 public:
     // Constructor.
     VariableMap() = default;
+    // Copy constructor and assignment.  The copy's keys refer to its own
+    // names rather than those of the original.
+    VariableMap(const VariableMap& other);
+    VariableMap& operator=(const VariableMap& other);
+    // Moving keeps the names where they are, so the keys stay valid.
+    VariableMap(VariableMap&& other) = default;
+    VariableMap& operator=(VariableMap&& other) = default;
     // Destructor.
     ~VariableMap() = default;
+    // Return the slot of a variable, interning the name if it is new.
+    int slot(std::string_view variable);
+    // Return the slot of a variable, or -1 if the name was never interned.
+    [[nodiscard]] int find(std::string_view variable) const;
+    // Return the name of the variable in a slot.
+    [[nodiscard]] const std::string& name(int slot) const;
     // Return the value of a variable.
-    [[nodiscard]] int get(const std::string& variable) const;
+    [[nodiscard]] int get(std::string_view variable) const;
+    // Return the value of the variable in a slot.
+    [[nodiscard]] int get(int slot) const;
+    // Return the values of all the variables, indexed by slot.  Only
+    // slots that have been checked with get() hold meaningful values.
+    [[nodiscard]] const int* values() const;
     // Set the value of a variable.
-    void set(const std::string& variable, int value);
+    void set(std::string_view variable, int value);
     // False if not variables are declared
     [[maybe_unused]] [[nodiscard]] bool isEmpty() const;
     // Print all variables and their values.
-    void print(std::ostream& os) const;
-    // Clear all variables and their values.
+    void print(OutputSink& os) const;
+    // Clear all variables and their values.  Slots stay interned so
+    // existing expression trees remain valid.
     [[maybe_unused]] void reset();
 
 private:
-    // Unordered map containing variable names and values.
-    std::unordered_map<std::string, int> map;
+    // Unordered map containing variable names and their slots.  The keys
+    // refer to the strings in names, so names can be looked up from a
+    // slice of the input without copying it.
+    std::unordered_map<std::string_view, int> slots;
+    // Name of the variable in each slot.  A deque never moves its
+    // elements, which keeps the keys of slots valid.
+    std::deque<std::string> names;
+    // Value of the variable in each slot.
+    std::vector<int> slotValues;
+    // Whether the variable in each slot has been set.
+    std::vector<bool> assigned;
+    // Number of variables that have been set.
+    std::size_t assignedCount = 0;
 };
 
 #endif // VARIABLE_MAP
@@ -0,0 +1,106 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @class OutputSink
+ * @brief A large write buffer in front of an output stream.
+ *
+ *        Text and integers are appended to the buffer, integers being
+ *        formatted with std::to_chars rather than through the stream's
+ *        locale machinery, and the buffer is only handed to the stream
+ *        when it fills up or flush() is called.  Nothing is flushed
+ *        implicitly at the end of a line, so the owner decides where
+ *        the flush points are (e.g. before prompting for input).
+ */
+class OutputSink {
+public:
+    // Default size of the buffer in bytes.
+    static constexpr std::size_t defaultCapacity = 64 * 1024;
+
+    // Ctor.
+    explicit OutputSink(std::ostream& os, std::size_t capacity = defaultCapacity)
+        : os(os)
+        , buffer(capacity)
+        , used(0)
+    {
+    }
+
+    // Dtor.  Flushes anything still buffered.
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+
+    // Append a character.
+    OutputSink& operator<<(char c)
+    {
+        if (used == buffer.size())
+            drain();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // Append text.  Text too big for the buffer bypasses it.
+    OutputSink& operator<<(std::string_view text)
+    {
+        if (text.size() > buffer.size() - used) {
+            drain();
+            if (text.size() > buffer.size()) {
+                os.write(text.data(), static_cast<std::streamsize>(text.size()));
+                return *this;
+            }
+        }
+        std::memcpy(buffer.data() + used, text.data(), text.size());
+        used += text.size();
+        return *this;
+    }
+
+    // Append an integer in decimal.
+    template <typename Integer,
+        typename = std::enable_if_t<std::is_integral_v<Integer> && !std::is_same_v<Integer, char>
+            && !std::is_same_v<Integer, bool>>>
+    OutputSink& operator<<(Integer value)
+    {
+        // room for every digit, plus a sign
+        constexpr std::size_t width = std::numeric_limits<Integer>::digits10 + 2;
+        if (buffer.size() - used < width)
+            drain();
+        auto result = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value);
+        used = static_cast<std::size_t>(result.ptr - buffer.data());
+        return *this;
+    }
+
+    // Hand everything buffered to the stream and flush it.
+    void flush()
+    {
+        drain();
+        os.flush();
+    }
+
+private:
+    // Hand everything buffered to the stream without flushing it.
+    void drain()
+    {
+        if (used > 0)
+            os.write(buffer.data(), static_cast<std::streamsize>(used));
+        used = 0;
+    }
+
+    // Where the output ends up.
+    std::ostream& os;
+    // Output that hasn't been written to the stream yet.
+    std::vector<char> buffer;
+    // Number of bytes of the buffer in use.
+    std::size_t used;
+};
+
+#endif // OUTPUT_SINK_H
@@ -2,10 +2,109 @@
 #ifndef REFCOUNTER_H
 #define REFCOUNTER_H
 
+#include <atomic>
+#ifdef EXPRESSION_TREE_TRACK_ALLOCATIONS
+#include "core/allocation_stats.h"
+#endif
+
+/**
+ * @struct PlainRefcount
+ * @brief Reference count policy using a plain int.  Cheapest, but
+ *        objects counted this way must not be shared between threads.
+ */
+struct PlainRefcount {
+    typedef int COUNT;
+
+    // Add a reference.
+    static void increment(COUNT& count) { ++count; }
+
+    // Drop a reference, returning true if it was the last one.
+    static bool decrement(COUNT& count) { return --count == 0; }
+};
+
+/**
+ * @struct AtomicRefcount
+ * @brief Reference count policy using a std::atomic<int>, so handles to
+ *        the same object can be copied and destroyed on different
+ *        threads.
+ */
+struct AtomicRefcount {
+    typedef std::atomic<int> COUNT;
+
+    // Add a reference.  Nothing is published by taking a reference, so
+    // relaxed ordering is enough.
+    static void increment(COUNT& count) { count.fetch_add(1, std::memory_order_relaxed); }
+
+    // Drop a reference, returning true if it was the last one.  The
+    // thread that deletes the object must see every other thread's
+    // writes to it, hence acquire-release.
+    static bool decrement(COUNT& count)
+    {
+        return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+};
+
+// The policy used for tree nodes, picked by the ATOMIC_REFCOUNT CMake option.
+#ifdef EXPRESSION_TREE_ATOMIC_REFCOUNT
+typedef AtomicRefcount DefaultRefcount;
+#else
+typedef PlainRefcount DefaultRefcount;
+#endif
+
+/**
+ * @class Refcounted
+ * @brief Base class that embeds a reference count in the objects
+ *        managed by Refcounter, so no separate count has to be
+ *        allocated for them.
+ */
+template <typename Policy = DefaultRefcount> class Refcounted {
+    template <typename T> friend class Refcounter;
+
+public:
+    // Ctor.  A new object has no references until a Refcounter takes it.
+    Refcounted()
+        : refcount(0)
+    {
+#ifdef EXPRESSION_TREE_TRACK_ALLOCATIONS
+        AllocationStats::created();
+#endif
+    }
+
+    // Copying an object doesn't copy its references.
+    Refcounted(const Refcounted&)
+        : refcount(0)
+    {
+#ifdef EXPRESSION_TREE_TRACK_ALLOCATIONS
+        AllocationStats::created();
+#endif
+    }
+
+    Refcounted& operator=(const Refcounted&) { return *this; }
+
+protected:
+    // Dtor.
+#ifdef EXPRESSION_TREE_TRACK_ALLOCATIONS
+    ~Refcounted() { AllocationStats::destroyed(); }
+#else
+    ~Refcounted() = default;
+#endif
+
+private:
+    // Current value of the reference count.
+    mutable typename Policy::COUNT refcount;
+
+    // implementation of the increment operation
+    void increment() const { Policy::increment(refcount); }
+
+    // implementation of the decrement operation
+    bool decrement() const { return Policy::decrement(refcount); }
+};
+
 /**
  * @class Refcounter
  * @brief This template class provides transparent reference counting
- *        of its template parameter T.
+ *        of its template parameter T, which must derive from
+ *        Refcounted.
  *
  *        This class can be used to automate the implementation of the
  *        Bridge pattern in C++.
@@ -15,22 +114,30 @@ public:
     // default Ctor
     Refcounter();
 
-    // Ctor with refcounting functionality
+    // Ctor with refcounting functionality.  If increaseCount is set an
+    // extra reference is taken, so this handle never deletes ptr.
     explicit Refcounter(T* ptr, bool increaseCount = false);
 
     // copy Ctor
     Refcounter(const Refcounter& rhs);
 
+    // move Ctor
+    Refcounter(Refcounter&& rhs) noexcept;
+
     // Dtor will delete pointer if refcount becomes 0
-    virtual ~Refcounter();
+    ~Refcounter();
 
-    // assignment operator for times when you don't want
-    // the reference increased for incoming ptr
+    // assignment operator from a raw pointer.  Like the ctor, this
+    // takes a reference to ptr (the count lives in the object itself)
+    // and drops the one held on the old object.
     Refcounter& operator=(T* ptr);
 
     // assignment operator
     Refcounter& operator=(const Refcounter& rhs);
 
+    // move assignment operator
+    Refcounter& operator=(Refcounter&& rhs) noexcept;
+
     // dereference operator
     T& operator*();
 
@@ -56,24 +163,8 @@ private:
     // implementation of the decrement operation
     void decrement();
 
-    // A shim class that keeps track of the reference count and a
-    // pointer to the type T that's reference counted.
-    struct Shim {
-        // Constructor.
-        explicit Shim(T* t);
-
-        // Destructor.
-        ~Shim();
-
-        // Pointer to the object that's being reference counted.
-        T* t;
-
-        // Current value of the reference count.
-        int refcount;
-    };
-
-    // Pointer to the Shim.
-    Shim* ptr;
+    // Pointer to the object that's being reference counted.
+    T* ptr;
 };
 
 #include "../src/refcounter.cpp"
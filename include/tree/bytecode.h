@@ -0,0 +1,94 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <cstdint>
+#include <vector>
+
+class VariableMap;
+
+/**
+ * @class Bytecode
+ * @brief A linear, postfix program that evaluates an expression tree.
+ *
+ *        A Bytecode is produced by ExpressionTree::compile() and run by
+ *        a tight interpreter loop over a value stack whose size is
+ *        computed while the program is emitted, so evaluating it needs
+ *        neither iterators nor virtual dispatch.
+ *
+ * @see   CompileVisitor
+ */
+class Bytecode {
+public:
+    // The operations understood by the interpreter loop.
+    enum class Opcode : std::uint8_t {
+        PushConst,
+        PushVar,
+        Negate,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Exponent,
+        Modulus,
+        Factorial,
+        Ceiling,
+        Floor,
+        Save,
+        Load
+    };
+
+    // A single instruction: the opcode and its operand (the value for
+    // PushConst, the variable slot for PushVar, the temporary for Save
+    // and Load).  Save copies the top of the stack into a temporary
+    // without popping it, and Load pushes a temporary back, which lets
+    // a program compute a shared subexpression once.
+    struct Instruction {
+        Opcode opcode;
+        std::int32_t operand;
+    };
+
+    // Ctor.
+    Bytecode();
+
+    // Append an instruction to the program.
+    void emit(Opcode opcode, int operand = 0);
+
+    // Return the number of instructions in the program.
+    [[nodiscard]] std::size_t size() const;
+
+    // Return the deepest the value stack gets while running.
+    [[nodiscard]] std::size_t stackDepth() const;
+
+    // Run the program with the designated variables, storing its yield
+    // in result.  Returns false if the program trapped on a division by
+    // zero, in which case result is left untouched.
+    bool run(const VariableMap& variables, int& result) const;
+
+    // Run the program once per row over columns of variable values and
+    // write each row's yield to out.  The columns are indexed by slot;
+    // a variable whose column is missing or nullptr takes its current
+    // value in variables on every row.  Each instruction is applied to
+    // a whole block of rows at a time so the arithmetic loops can be
+    // vectorized by the compiler.  Like run(), a row that divides by
+    // zero traps: its index is appended to trapped and its entry in out
+    // is meaningless.
+    void runBatch(const VariableMap& variables, const std::vector<const int*>& columns,
+        std::size_t rows, int* out, std::vector<std::size_t>& trapped) const;
+
+private:
+    // The instructions in execution order.
+    std::vector<Instruction> code;
+    // Slots of the variables the program reads.
+    std::vector<int> slots;
+    // Whether each slot is already in slots.
+    std::vector<bool> reads;
+    // Depth of the value stack after the last emitted instruction.
+    std::size_t depth;
+    // Maximum depth of the value stack.
+    std::size_t maxDepth;
+    // Number of temporaries used by Save and Load.
+    std::size_t temps;
+};
+
+#endif // BYTECODE_H
@@ -2,6 +2,7 @@
 #ifndef COMPONENT_NODE_H
 #define COMPONENT_NODE_H
 
+#include "refcounter.h"
 #include <stdexcept>
 
 // Forward declaration.
@@ -18,10 +19,14 @@ class Visitor;
  *        pattern don't have to implement methods they don't care
  *        about.
  *
+ *        Nodes carry their own reference count (see Refcounted) so
+ *        that an ExpressionTree can own one without a separate
+ *        allocation for the count.
+ *
  * @see   See CompositeUnaryNode and CompositeBinaryNode for nodes
  *        with right only and left and right children, respectively.
  */
-class ComponentNode {
+class ComponentNode : public Refcounted<> {
 public:
     // Dtor
     virtual ~ComponentNode() = default;
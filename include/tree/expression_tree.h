@@ -3,13 +3,19 @@
 #define EXPRESSION_TREE_H
 
 #include "refcounter.h"
+#include "tree/bytecode.h"
 #include "tree/component_node.h"
+#include "tree/flat_tree.h"
+#include <iosfwd>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 // Forward declarations.
 class ExpressionTreeIterator;
 class ExpressionTreeConstIterator;
+class VariableMap;
 
 /**
  * @class ExpressionTree
@@ -44,9 +50,16 @@ public:
     // Ctor that takes a Node * that contains all the nodes in the expression tree.
     explicit ExpressionTree(ComponentNode* root, bool increment = false);
 
+    // Ctor that takes ownership of a FlatTree holding all the nodes in
+    // the expression tree.
+    explicit ExpressionTree(FlatTree* tree);
+
     // Copy ctor
     ExpressionTree(const ExpressionTree& rhs);
 
+    // Move ctor
+    ExpressionTree(ExpressionTree&& rhs) noexcept;
+
     // Gain access to the underlying root pointer functions are useful
     // to the iterators.
     ComponentNode* getRoot();
@@ -54,8 +67,13 @@ public:
     // Assignment operator.
     ExpressionTree& operator=(const ExpressionTree& t);
 
+    // Move assignment operator.
+    ExpressionTree& operator=(ExpressionTree&& t) noexcept;
+
     bool operator==(const ExpressionTree& rhs) const;
 
+    bool operator!=(const ExpressionTree& rhs) const;
+
     // Dtor
     ~ExpressionTree() = default;
 
@@ -90,11 +108,51 @@ public:
     // Accept a visitor to perform some action on the Expression_Tree.
     void accept(Visitor& visitor) const;
 
+    // Compile the tree into a postfix Bytecode program.
+    [[nodiscard]] Bytecode compile() const;
+
+    // Return an equivalent tree with constant subtrees folded and
+    // algebraic identities removed, setting removed to the number of
+    // nodes that were dropped.  If share is set, repeated
+    // subexpressions in the result share their nodes.
+    [[nodiscard]] ExpressionTree simplify(std::size_t& removed, bool share = false) const;
+
+    // Evaluate the tree once per row of the designated columns of
+    // variable values, which must all be the same length.  Variables
+    // without a column take their value in variables on every row.
+    // Each row yields what evaluating the tree with that row's values
+    // would, including on a division by zero.
+    [[nodiscard]] std::vector<int> evaluateBatch(const VariableMap& variables,
+        const std::unordered_map<std::string, std::vector<int>>& columns) const;
+
+    // Write the tree to the designated stream as an archive holding just
+    // this tree (see TreeWriter).
+    void save(std::ostream& os, const VariableMap& variables) const;
+
+    // Read the first tree of an archive, interning the names of its
+    // variables in variables.
+    static ExpressionTree load(std::istream& is, VariableMap& variables);
+
 private:
-    // Pointer to actual implementation, i.e., the "bridge", which is
-    // reference counted to automate memory management.
+    // Ctor for a subtree of a FlatTree that is already reference counted.
+    ExpressionTree(const Refcounter<FlatTree>& tree, FlatTree::Index index);
+
+    // Ctor for a subtree of a node tree whose root is already reference
+    // counted.
+    ExpressionTree(const Refcounter<ComponentNode>& root, ComponentNode* node);
+
+    // Pointer to the root of the whole tree, which is reference counted
+    // to automate memory management.  Subtrees share it with the tree
+    // they came from, so they keep it alive without allocating.
     Refcounter<ComponentNode> root;
     //    std::shared_ptr<ComponentNode> root;
+    // Pointer to actual implementation, i.e., the "bridge": the node
+    // at the top of this (sub)tree, which is owned through root.
+    ComponentNode* node;
+    // Alternatively, the arena holding the nodes when the tree was built
+    // as a FlatTree, along with the index of this tree's root in it.
+    Refcounter<FlatTree> flat;
+    FlatTree::Index index;
 };
 
 #endif // EXPRESSION_TREE_H
@@ -7,6 +7,8 @@
 #include <queue>
 #include <stack>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 // Solve circular include problem
 class ComponentNode;
@@ -63,6 +65,11 @@ public:
     typedef int difference_type;
 
 protected:
+    // Stack of subtrees used by the depth-first iterators.  Backing it
+    // with a vector means its storage is reused as the traversal goes
+    // rather than allocated in chunks.
+    typedef std::stack<ExpressionTree, std::vector<ExpressionTree>> TREE_STACK;
+
     // The tree we are iterating over.
     const ExpressionTree& tree;
 };
@@ -115,7 +122,7 @@ public:
 
 private:
     // Our current position in the iteration.
-    std::stack<ExpressionTree> stack;
+    TREE_STACK stack;
 };
 
 /**
@@ -166,7 +173,7 @@ public:
 
 private:
     // Our current position in the iteration.
-    std::stack<ExpressionTree> stack;
+    TREE_STACK stack;
 };
 
 /**
@@ -216,8 +223,17 @@ public:
     typedef int difference_type;
 
 private:
+    // A node on the stack, and whether its children have been pushed
+    // above it yet.  A shared node can be the child of more than one
+    // parent, so that can't be told from the nodes themselves.
+    typedef std::pair<ExpressionTree, bool> FRAME;
+
+    // Push the children of the node on top of the stack, and then
+    // those of its leftmost descendants, until a leaf is on top.
+    void descend();
+
     // Our current position in the iteration.
-    std::stack<ExpressionTree> stack;
+    std::stack<FRAME, std::vector<FRAME>> stack;
 };
 
 /**
@@ -0,0 +1,155 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef FLAT_TREE_H
+#define FLAT_TREE_H
+
+#include "refcounter.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Forward declaration.
+class Bytecode;
+class Visitor;
+
+/**
+ * @class FlatTree
+ * @brief Contiguous storage for all the nodes of an expression tree.
+ *
+ *        Every node lives in a single vector and refers to its
+ *        children by 32-bit index rather than by pointer, so building
+ *        a tree costs one (amortized) allocation instead of one per
+ *        node, and traversals walk a dense array.  Children are always
+ *        added before their parents, which leaves the nodes in
+ *        post-order with the root at the back.
+ *
+ *        A FlatTree can optionally hash-cons its nodes: a node that is
+ *        structurally identical to one already in the tree isn't added
+ *        again, and the existing index is returned instead.  Repeated
+ *        subexpressions then share a single node, turning the tree into
+ *        a DAG.  Since every node still comes after its children, the
+ *        post-order layout is unchanged.
+ *
+ *        This class plays the role of an alternative "implementor" for
+ *        ExpressionTree in the Bridge pattern.  Existing visitors work
+ *        unchanged via accept(), which presents each node to the
+ *        visitor as the equivalent ComponentNode subclass.
+ *
+ * @see   ExpressionTree, Symbol::build(FlatTree&)
+ */
+class FlatTree : public Refcounted<> {
+public:
+    // Type used to refer to a node in the tree.
+    using Index = std::uint32_t;
+
+    // Index value meaning "no node", e.g. the left child of a negation.
+    static constexpr Index npos = ~Index(0);
+
+    // The operation performed by a node.
+    enum class Opcode : std::uint8_t {
+        Number,
+        Variable,
+        Negate,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Exponent,
+        Modulus,
+        Factorial,
+        Ceiling,
+        Floor
+    };
+
+    // A single node: the opcode, its integer payload (the value of a
+    // Number, the VariableMap slot of a Variable) and the indices of its
+    // children.
+    struct Node {
+        Opcode opcode;
+        std::int32_t payload;
+        Index left;
+        Index right;
+    };
+
+    // Ctor.  If share is set, repeated subtrees share a single node.
+    explicit FlatTree(bool share = false);
+
+    // Dtor.
+    ~FlatTree() = default;
+
+    // Reserve room for the designated number of nodes.
+    void reserve(std::size_t nodes);
+
+    // Append a leaf holding the designated value and return its index.
+    Index makeLeaf(int value);
+
+    // Append a leaf referring to the variable in the designated slot
+    // and return its index.
+    Index makeVariable(std::string_view name, int slot);
+
+    // Append a unary node (Negate or Factorial) and return its index.
+    Index makeUnary(Opcode opcode, Index child);
+
+    // Append a binary node and return its index.
+    Index makeBinary(Opcode opcode, Index left, Index right);
+
+    // Return the number of nodes in the tree.
+    [[nodiscard]] std::size_t size() const;
+
+    // Check if the tree has no nodes.
+    [[nodiscard]] bool empty() const;
+
+    // Return the index of the root node (the most recently added one).
+    [[nodiscard]] Index root() const;
+
+    // Return the designated node.
+    [[nodiscard]] const Node& node(Index index) const;
+
+    // Return the name of the variable in the designated slot.
+    [[nodiscard]] const std::string& name(int slot) const;
+
+    // Return the item stored in the designated node, using the same
+    // conventions as ComponentNode::item().
+    [[nodiscard]] int item(Index index) const;
+
+    // Return the left child of the designated node (or npos).
+    [[nodiscard]] Index left(Index index) const;
+
+    // Return the right child of the designated node (or npos).
+    [[nodiscard]] Index right(Index index) const;
+
+    // Accept a visitor on the designated node.
+    void accept(Index index, Visitor& visitor) const;
+
+    // Compile the subtree rooted at the designated node into a postfix
+    // Bytecode program.  A node shared by several parents is computed
+    // once and its value saved for the others.
+    [[nodiscard]] Bytecode compile(Index index) const;
+
+private:
+    // Hash function used to intern nodes.
+    struct NodeHash {
+        std::size_t operator()(const Node& node) const;
+    };
+
+    // Equality used to intern nodes.
+    struct NodeEqual {
+        bool operator()(const Node& lhs, const Node& rhs) const;
+    };
+
+    // Add a node, or find the identical node already in the tree when
+    // sharing, and return its index.
+    Index append(const Node& node);
+
+    // All the nodes of the tree in post-order.
+    std::vector<Node> nodes;
+    // Are repeated subtrees shared or not?
+    bool share;
+    // Index of each distinct node, used when sharing.
+    std::unordered_map<Node, Index, NodeHash, NodeEqual> interned;
+    // Names of the variables referred to by the tree, indexed by slot.
+    std::vector<std::string> names;
+};
+
+#endif // FLAT_TREE_H
@@ -0,0 +1,78 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef INCREMENTAL_EVALUATOR_H
+#define INCREMENTAL_EVALUATOR_H
+
+#include "tree/flat_tree.h"
+#include <cstdint>
+#include <vector>
+
+// Forward declarations.
+class ExpressionTree;
+class VariableMap;
+
+/**
+ * @class IncrementalEvaluator
+ * @brief Evaluates an expression tree, remembering the value of every
+ *        node so that it can be re-evaluated after a variable changes
+ *        by recomputing only the nodes that depend on that variable.
+ *
+ *        Each node keeps a link to its parent, and each variable slot
+ *        maps to the leaves that read it.  invalidate() marks the path
+ *        from those leaves to the root dirty, stopping as soon as it
+ *        meets a node that is already dirty, and evaluate() recomputes
+ *        just the dirty nodes, so a change costs time proportional to
+ *        the depth of the tree rather than its size.
+ */
+class IncrementalEvaluator {
+public:
+    // Ctor.  Every node starts out dirty.
+    explicit IncrementalEvaluator(const ExpressionTree& tree);
+
+    // Mark every node that depends on the variable in the designated
+    // slot as needing to be recomputed.
+    void invalidate(int slot);
+
+    // Recompute the dirty nodes, storing the value of the tree in
+    // result.  Returns false if a division by zero trapped, in which
+    // case result is left untouched.  The semantics of each operator
+    // match those of EvaluationVisitor, including the exceptions.
+    bool evaluate(const VariableMap& variables, int& result);
+
+    // Return the number of nodes recomputed by the last evaluate().
+    [[nodiscard]] std::size_t recomputed() const;
+
+private:
+    // Type used to refer to a node.
+    using Index = FlatTree::Index;
+
+    // A node of the tree, stored in post-order.
+    struct Node {
+        FlatTree::Opcode opcode;
+        // Value of a Number, slot of a Variable.
+        std::int32_t payload;
+        Index left;
+        Index right;
+        Index parent;
+    };
+
+    // Visitor that fills in the nodes.
+    class Recorder;
+
+    // Mark a node and its ancestors dirty.
+    void markDirty(Index index);
+
+    // All the nodes, with the root at the back.
+    std::vector<Node> nodes;
+    // Last computed value of each node.
+    std::vector<int> values;
+    // Whether each node needs to be recomputed.
+    std::vector<bool> dirty;
+    // Nodes that need to be recomputed, in no particular order.
+    std::vector<Index> pending;
+    // Leaves that read each variable slot.
+    std::vector<std::vector<Index>> readers;
+    // Number of nodes recomputed by the last evaluate().
+    std::size_t lastRecomputed;
+};
+
+#endif // INCREMENTAL_EVALUATOR_H
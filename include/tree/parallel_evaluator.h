@@ -0,0 +1,55 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef PARALLEL_EVALUATOR_H
+#define PARALLEL_EVALUATOR_H
+
+#include "tree/variant_tree.h"
+#include <atomic>
+#include <vector>
+
+// Forward declarations.
+class VariableMap;
+class WorkStealingPool;
+
+/**
+ * @class ParallelEvaluator
+ * @brief Evaluates a large VariantTree on a WorkStealingPool.
+ *
+ *        The left subtree of every binary node bigger than a cutoff is
+ *        forked onto the pool while the calling thread evaluates the
+ *        right subtree, and the node itself is computed once both are
+ *        joined.  Subtrees at or below the cutoff are evaluated
+ *        sequentially.  Since the tree is stored in post-order, every
+ *        subtree is a contiguous range of nodes, so each task writes a
+ *        disjoint part of a shared array of values.
+ */
+class ParallelEvaluator {
+public:
+    // Default number of nodes below which subtrees aren't split.
+    static constexpr std::size_t defaultCutoff = 8192;
+
+    // Ctor.  The tree and the pool must outlive the evaluator.
+    ParallelEvaluator(
+        const VariantTree& tree, WorkStealingPool& pool, std::size_t cutoff = defaultCutoff);
+
+    // Evaluate the tree, storing its yield in result.  Returns false on
+    // a division by zero, in which case result is left untouched.  If
+    // any part of the tree traps or throws, the whole tree is evaluated
+    // again sequentially, so errors are reported exactly as
+    // VariantTree::evaluate() reports them.
+    bool evaluate(const VariableMap& variables, int& result) const;
+
+private:
+    using Index = VariantTree::Index;
+
+    // Evaluate the subtree rooted at the designated node.
+    void evaluate(Index index, const VariableMap& variables, std::vector<int>& values,
+        std::atomic<bool>& failed) const;
+
+    const VariantTree& tree;
+    WorkStealingPool& pool;
+    std::size_t cutoff;
+    // Number of nodes in the subtree rooted at each node.
+    std::vector<Index> sizes;
+};
+
+#endif // PARALLEL_EVALUATOR_H
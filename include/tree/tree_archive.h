@@ -0,0 +1,151 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef TREE_ARCHIVE_H
+#define TREE_ARCHIVE_H
+
+#include "tree/expression_tree.h"
+#include <cstdint>
+#include <iosfwd>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class VariableMap;
+
+/**
+ * @class TreeWriter
+ * @brief Collects expression trees and writes them out as a binary
+ *        archive that TreeArchive can read back.
+ *
+ *        An archive is laid out as follows, where every number is an
+ *        unsigned LEB128 varint unless noted otherwise:
+ *
+ *          "ETA1"                      magic and format version
+ *          names, then each name       length and bytes of every
+ *                                      variable name the trees use
+ *          trees, then each tree:
+ *            key                       length and bytes, e.g. the
+ *                                      expression's normalized text
+ *            code                      length and bytes of the tree's
+ *                                      nodes in pre-order
+ *
+ *        Each node is a FlatTree::Opcode byte, followed by the value of
+ *        a Number (zigzag encoded, so small negative numbers stay short)
+ *        or the index in the name table of a Variable.  Operators have
+ *        no payload; their operands simply follow them.  Shared
+ *        subexpressions are written out in full at every use.
+ */
+class TreeWriter {
+public:
+    // Ctor.  The trees added refer to variables in the designated map.
+    explicit TreeWriter(const VariableMap& variables);
+
+    // Add a tree to the archive under the designated key.
+    void add(const ExpressionTree& tree, std::string_view key = {});
+
+    // Return the number of trees added.
+    [[nodiscard]] std::size_t size() const;
+
+    // Write the archive to the designated stream.
+    void write(std::ostream& os) const;
+
+private:
+    class Encoder;
+
+    // Return the index in names of the variable in a slot.
+    std::uint32_t name(int slot);
+
+    // The variables the trees refer to.
+    const VariableMap& variables;
+    // Names used by the trees, in the order they were first seen.
+    std::vector<std::string> names;
+    // Index in names of each VariableMap slot seen so far.
+    std::unordered_map<int, std::uint32_t> nameIndex;
+    // The key and encoded nodes of each tree.
+    std::vector<std::pair<std::string, std::string>> trees;
+};
+
+/**
+ * @class TreeArchive
+ * @brief Read-only access to the trees in an archive written by
+ *        TreeWriter.
+ *
+ *        An archive file is mapped into memory rather than read, and
+ *        opening it only indexes where each tree starts, so opening an
+ *        archive of any size is quick.  A tree can be evaluated straight
+ *        from its encoded bytes, without building any nodes, or turned
+ *        back into an ExpressionTree when one is needed.
+ */
+class TreeArchive {
+public:
+    // Exception thrown for a file that isn't a valid archive.
+    class InvalidArchive : public std::runtime_error {
+    public:
+        explicit InvalidArchive(const std::string& message)
+            : std::runtime_error(message)
+        {
+        }
+    };
+
+    // Ctor that maps the archive at the designated path, interning the
+    // names of its variables in variables.
+    TreeArchive(const std::string& path, VariableMap& variables);
+
+    // Ctor that reads the whole archive from a stream.
+    TreeArchive(std::istream& is, VariableMap& variables);
+
+    // Dtor.  Unmaps the file.
+    ~TreeArchive();
+
+    TreeArchive(const TreeArchive&) = delete;
+    TreeArchive& operator=(const TreeArchive&) = delete;
+
+    // Return the number of trees in the archive.
+    [[nodiscard]] std::size_t size() const;
+
+    // Return the key of the designated tree.
+    [[nodiscard]] std::string_view key(std::size_t tree) const;
+
+    // Look up the tree with the designated key, returning false if
+    // there isn't one.
+    bool find(std::string_view key, std::size_t& tree) const;
+
+    // Evaluate the designated tree straight from the archive, with the
+    // variables in the map given to the ctor, storing its yield in
+    // result.  Returns false if the tree divides by zero, in which case
+    // result is left untouched.
+    bool evaluate(std::size_t tree, const VariableMap& variables, int& result) const;
+
+    // Build the designated tree as a FlatTree.  If share is set,
+    // repeated subexpressions share their nodes.
+    [[nodiscard]] ExpressionTree tree(std::size_t tree, bool share = false) const;
+
+private:
+    // Where each tree's key and code are.
+    struct Entry {
+        std::string_view key;
+        const std::uint8_t* code;
+        const std::uint8_t* end;
+    };
+
+    // Index the archive in [data, data + length).
+    void open(VariableMap& variables);
+
+    // The whole archive, either mapped or read into contents.
+    const std::uint8_t* data;
+    std::size_t length;
+    // Whether data is mapped.
+    bool mapped;
+    // The archive when it was read from a stream.
+    std::string contents;
+    // The variable names in the archive, and their slots.
+    std::vector<std::string> names;
+    std::vector<int> slots;
+    // Every tree in the archive.
+    std::vector<Entry> entries;
+    // Index of each tree by key.
+    std::unordered_map<std::string_view, std::size_t> keys;
+};
+
+#endif // TREE_ARCHIVE_H
@@ -0,0 +1,39 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef VARIABLE_NODE_H
+#define VARIABLE_NODE_H
+
+#include "tree/component_node.h"
+#include <string>
+
+/**
+ * @class VariableNode
+ * @brief Defines a terminal node that refers to a variable.  The value
+ *        of the variable is looked up in a VariableMap by slot each time
+ *        the tree is evaluated, so the tree doesn't need to be rebuilt
+ *        when the variable is set.
+ */
+class VariableNode : public ComponentNode {
+public:
+    // Ctor.
+    VariableNode(std::string name, int slot);
+
+    // Dtor.
+    ~VariableNode() override = default;
+
+    // Return the slot of the variable in the VariableMap.
+    [[nodiscard]] int item() const override;
+
+    // Return the name of the variable.
+    [[nodiscard]] const std::string& name() const;
+
+    // Define the accept() operation used for the Visitor pattern.
+    void accept(Visitor& visitor) const override;
+
+private:
+    // Name of the variable.
+    std::string variable;
+    // Slot of the variable in the VariableMap.
+    int slot;
+};
+
+#endif // VARIABLE_NODE_H
@@ -0,0 +1,117 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef VARIANT_TREE_H
+#define VARIANT_TREE_H
+
+#include <cstdint>
+#include "output_sink.h"
+#include <string>
+#include <variant>
+#include <vector>
+
+// Forward declarations.
+class ExpressionTree;
+class VariableMap;
+
+/**
+ * @class VariantTree
+ * @brief A closed representation of an expression tree in which every
+ *        node is a std::variant over the node kinds.
+ *
+ *        The class hierarchy rooted at ComponentNode costs two virtual
+ *        calls per node visited: one for accept() and one back into the
+ *        Visitor.  Since the set of node kinds is fixed, a VariantTree
+ *        instead stores plain structs in a single vector, in post-order,
+ *        and evaluates and prints them with std::visit over an overload
+ *        set, which lets the compiler inline each operator's kernel into
+ *        the dispatch.
+ *
+ * @see   ExpressionTree, EvaluationVisitor, PrintVisitor
+ */
+class VariantTree {
+public:
+    // Type used to refer to a node in the tree.
+    using Index = std::uint32_t;
+
+    // Index value meaning "no node".
+    static constexpr Index npos = ~Index(0);
+
+    // The children of a binary node.
+    struct Operands {
+        Index left;
+        Index right;
+    };
+
+    // The node kinds.  Unary nodes keep their child on the right, like
+    // UnaryNode does.
+    struct Number {
+        int value;
+    };
+    struct Variable {
+        int slot;
+    };
+    struct Negate {
+        Index right;
+    };
+    struct Factorial {
+        Index right;
+    };
+    struct Add : Operands { };
+    struct Subtract : Operands { };
+    struct Multiply : Operands { };
+    struct Divide : Operands { };
+    struct Exponent : Operands { };
+    struct Modulus : Operands { };
+    struct Ceiling : Operands { };
+    struct Floor : Operands { };
+
+    // A single node.
+    using Node = std::variant<Number, Variable, Negate, Factorial, Add, Subtract, Multiply, Divide,
+        Exponent, Modulus, Ceiling, Floor>;
+
+    // Ctor.  Converts the designated tree.
+    explicit VariantTree(const ExpressionTree& tree);
+
+    // Return the number of nodes in the tree.
+    [[nodiscard]] std::size_t size() const;
+
+    // Evaluate the tree with the designated variables, storing its
+    // yield in result.  Returns false on a division by zero, in which
+    // case result is left untouched.  The semantics of each operator
+    // match those of EvaluationVisitor, including the exceptions.
+    bool evaluate(const VariableMap& variables, int& result) const;
+
+    // Evaluate the nodes from first to last inclusive, in post-order,
+    // storing the value of each node at its index in values.  The
+    // operands of those nodes must be in the range or already in
+    // values.  Returns false on a division by zero.
+    bool evaluate(
+        Index first, Index last, const VariableMap& variables, std::vector<int>& values) const;
+
+    // Return the left and right children of a node (or npos).
+    [[nodiscard]] Operands children(Index index) const;
+
+    // Print the tree in the designated traversal order, producing the
+    // same output as a PrintVisitor.
+    void print(const std::string& order, OutputSink& os) const;
+
+private:
+    // Visitor that fills in the nodes.
+    class Recorder;
+
+    // Print a single node.
+    void print(Index index, OutputSink& os) const;
+
+    // Print the subtree rooted at the designated node in order.
+    void printInOrder(Index index, OutputSink& os) const;
+
+    // Print the subtree rooted at the designated node in pre-order.
+    void printPreOrder(Index index, OutputSink& os) const;
+
+    // All the nodes of the tree in post-order, with the root at the
+    // back.
+    std::vector<Node> nodes;
+    // Names of the variables referred to by the tree, indexed by slot.
+    std::vector<std::string> names;
+};
+
+#endif // VARIANT_TREE_H
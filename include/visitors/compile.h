@@ -0,0 +1,49 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef COMPILE_H
+#define COMPILE_H
+
+#include "tree/bytecode.h"
+#include "visitors/visitor.h"
+
+/**
+ * @class CompileVisitor
+ * @brief This plays the role of a visitor for translating the nodes
+ *        of an expression tree that is being iterated in post-order
+ *        fashion into a Bytecode program (and does not work correctly
+ *        with any other iterator).
+ */
+class CompileVisitor : public Visitor {
+public:
+    // Visit a LeafNode.
+    void visit(const LeafNode& node) override;
+    // Visit a VariableNode.
+    void visit(const VariableNode& node) override;
+    // Visit a NegateNode.
+    void visit(const NegateNode& node) override;
+    // Visit a AddNode.
+    void visit(const AddNode& node) override;
+    // Visit a SubtractNode.
+    void visit(const SubtractNode& node) override;
+    // Visit a DivideNode.
+    void visit(const DivideNode& node) override;
+    // Visit a MultiplyNode.
+    void visit(const MultiplyNode& node) override;
+    // Visit a ExponentNode.
+    void visit(const ExponentNode& node) override;
+    // Visit a ModulusNode.
+    void visit(const ModulusNode& node) override;
+    // Visit a FactorialNode.
+    void visit(const FactorialNode& node) override;
+    // Visit a CeilingNode.
+    void visit(const CeilingNode& node) override;
+    // Visit a FloorNode.
+    void visit(const FloorNode& node) override;
+    // Return the program compiled so far.
+    const Bytecode& program() const;
+
+private:
+    // Program being emitted.
+    Bytecode bytecode;
+};
+
+#endif // COMPILE_H
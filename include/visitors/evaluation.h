@@ -5,6 +5,8 @@
 #include "visitors/visitor.h"
 #include <stack>
 
+class VariableMap;
+
 /**
  * @class EvaluationVisitor
  * @brief This plays the role of a visitor for evaluating
@@ -14,8 +16,14 @@
  */
 class EvaluationVisitor : public Visitor {
 public:
+    // Ctor for trees without variables.
+    EvaluationVisitor();
+    // Ctor that looks variables up in the designated VariableMap.
+    explicit EvaluationVisitor(const VariableMap& variables);
     // Visit a LeafNode.
     void visit(const LeafNode& node) override;
+    // Visit a VariableNode.
+    void visit(const VariableNode& node) override;
     // Visit a NegateNode.
     void visit(const NegateNode& node) override;
     // Visit a AddNode.
@@ -44,6 +52,8 @@ public:
 private:
     // Stack used for temporarily storing evaluations.
     std::stack<int> stack;
+    // Where the values of variables are found (may be nullptr).
+    const VariableMap* variables;
 };
 
 #endif // EVALUATION_H
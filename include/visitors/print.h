@@ -3,7 +3,7 @@
 #define PRINT_H
 
 #include "visitors/visitor.h"
-#include <ostream>
+#include "output_sink.h"
 
 /**
  * @class PrintVisitor
@@ -13,13 +13,15 @@
 
 class PrintVisitor : public Visitor {
 public:
-    explicit PrintVisitor(std::ostream& os)
+    explicit PrintVisitor(OutputSink& os)
         : os(os)
     {
     }
 
     // Visits a LeafNode and prints it contents to output stream.
     void visit(const LeafNode& node) override;
+    // Visits a VariableNode and prints its name to output stream.
+    void visit(const VariableNode& node) override;
     // Visit a NegateNode and prints its contents to output stream.
     void visit(const NegateNode& node) override;
     // Visit a AddNode and prints its contents to output stream.
@@ -42,7 +44,7 @@ public:
     void visit(const FloorNode& node) override;
 
 private:
-    std::ostream& os;
+    OutputSink& os;
 };
 
 #endif // PRINT_H
@@ -0,0 +1,96 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+#include "tree/expression_tree.h"
+#include "tree/flat_tree.h"
+#include "visitors/visitor.h"
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class SimplifyVisitor
+ * @brief This plays the role of a visitor for rewriting an expression
+ *        tree that is being iterated in post-order fashion (and does
+ *        not work correctly with any other iterator) into a smaller,
+ *        equivalent FlatTree.
+ *
+ *        Subtrees made only of literals are folded into a single leaf,
+ *        and identities such as x+0, x*1, x^1 and --x, as well as
+ *        annihilators such as x*0 and x^0, are removed.  Nothing that
+ *        would raise an error when evaluated (division or modulus by
+ *        zero, a factorial out of range) is folded, and an annihilator
+ *        never discards an operand that could raise one, so the
+ *        simplified tree fails exactly when the original does, except
+ *        that a discarded variable no longer has to be set.
+ */
+class SimplifyVisitor : public Visitor {
+public:
+    // Ctor.
+    SimplifyVisitor();
+    // Visit a LeafNode.
+    void visit(const LeafNode& node) override;
+    // Visit a VariableNode.
+    void visit(const VariableNode& node) override;
+    // Visit a NegateNode.
+    void visit(const NegateNode& node) override;
+    // Visit a AddNode.
+    void visit(const AddNode& node) override;
+    // Visit a SubtractNode.
+    void visit(const SubtractNode& node) override;
+    // Visit a DivideNode.
+    void visit(const DivideNode& node) override;
+    // Visit a MultiplyNode.
+    void visit(const MultiplyNode& node) override;
+    // Visit a ExponentNode.
+    void visit(const ExponentNode& node) override;
+    // Visit a ModulusNode.
+    void visit(const ModulusNode& node) override;
+    // Visit a FactorialNode.
+    void visit(const FactorialNode& node) override;
+    // Visit a CeilingNode.
+    void visit(const CeilingNode& node) override;
+    // Visit a FloorNode.
+    void visit(const FloorNode& node) override;
+
+    // Return the simplified tree.  If share is set, repeated
+    // subexpressions in it share their nodes.
+    [[nodiscard]] ExpressionTree tree(bool share = false) const;
+
+    // Return how many fewer nodes the simplified tree has than the
+    // tree visited.
+    [[nodiscard]] std::size_t removed() const;
+
+private:
+    // A simplified subtree.
+    struct Value {
+        // Root of the subtree in scratch.
+        FlatTree::Index index;
+        // Is the subtree a single literal?
+        bool constant;
+        // The value of the literal.
+        int value;
+        // Could evaluating the subtree raise an error?
+        bool canTrap;
+        // Number of nodes in the subtree.
+        std::size_t size;
+    };
+
+    // Push a literal.
+    void constant(int value);
+    // Simplify a unary operator applied to the value on top of the stack.
+    void unary(FlatTree::Opcode opcode);
+    // Simplify a binary operator applied to the two values on top of
+    // the stack.
+    void binary(FlatTree::Opcode opcode);
+
+    // Every node built while simplifying, including ones that were
+    // later simplified away.
+    FlatTree scratch;
+    // Simplified subtrees that still need a parent.
+    std::vector<Value> stack;
+    // Number of nodes visited.
+    std::size_t count;
+};
+
+#endif // SIMPLIFY_H
@@ -3,6 +3,7 @@
 #define VISITOR_H
 
 class LeafNode;
+class VariableNode;
 class NegateNode;
 class AddNode;
 class SubtractNode;
@@ -26,6 +27,8 @@ class Visitor {
 public:
     // Visit a LeafNode.
     virtual void visit(const LeafNode& node) = 0;
+    // Visit a VariableNode.
+    virtual void visit(const VariableNode& node) = 0;
     // Visit a NegateNode.
     virtual void visit(const NegateNode& node) = 0;
     // Visit a AddNode.
@@ -0,0 +1,15 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "commands/cache.h"
+#include "core/context.h"
+
+CacheCommand::CacheCommand(Context& context, std::string capacity)
+    : Command_Impl(context)
+    , capacity(std::move(capacity))
+{
+}
+
+bool CacheCommand::execute()
+{
+    context.cache(capacity);
+    return true;
+}
@@ -1,5 +1,6 @@
 /* Copyright G. Hemingway @ 2022, All Rights Reserved */
 #include "commands/command_factory.h"
+#include "commands/cache.h"
 #include "commands/command.h"
 #include "commands/eval.h"
 #include "commands/expr.h"
@@ -7,11 +8,16 @@
 #include "commands/get.h"
 #include "commands/history.h"
 #include "commands/list.h"
+#include "commands/load.h"
 #include "commands/macro.h"
 #include "commands/null.h"
+#include "commands/optimize.h"
 #include "commands/print.h"
 #include "commands/quit.h"
+#include "commands/save.h"
 #include "commands/set.h"
+#include "commands/stats.h"
+#include "commands/trace.h"
 #include "core/context.h"
 #include <stdexcept>
 #include <string>
@@ -30,13 +36,20 @@ CommandFactory::CommandFactory(Context& cntx)
     commandMap["get"] = &CommandFactory::makeGetCommand;
     commandMap["list"] = &CommandFactory::makeListCommand;
     commandMap["history"] = &CommandFactory::makeHistoryCommand;
+    commandMap["cache"] = &CommandFactory::makeCacheCommand;
+    commandMap["optimize"] = &CommandFactory::makeOptimizeCommand;
+    commandMap["save"] = &CommandFactory::makeSaveCommand;
+    commandMap["load"] = &CommandFactory::makeLoadCommand;
+    commandMap["stats"] = &CommandFactory::makeStatsCommand;
+    commandMap["trace"] = &CommandFactory::makeTraceCommand;
 }
 
 Command CommandFactory::makeCommand(const std::string& input)
 {
-    // separate the command from the parameters
+    // separate the command from the parameters, which are empty if
+    // there is no space
     std::string::size_type spacePos = input.find(' ');
-    std::string parameters = input.substr(spacePos + 1);
+    std::string parameters = spacePos == std::string::npos ? "" : input.substr(spacePos + 1);
     std::string keyword = input.substr(0, spacePos);
     for (uint32_t i = 0; i < keyword.length(); ++i) {
         keyword[i] = tolower(keyword[i]);
@@ -102,6 +115,36 @@ Command CommandFactory::makeHistoryCommand(const std::string& params)
     return Command(new HistoryCommand(context, params));
 }
 
+Command CommandFactory::makeCacheCommand(const std::string& params)
+{
+    return Command(new CacheCommand(context, params));
+}
+
+Command CommandFactory::makeOptimizeCommand(const std::string&)
+{
+    return Command(new OptimizeCommand(context));
+}
+
+Command CommandFactory::makeSaveCommand(const std::string& params)
+{
+    return Command(new SaveCommand(context, params));
+}
+
+Command CommandFactory::makeLoadCommand(const std::string& params)
+{
+    return Command(new LoadCommand(context, params));
+}
+
+Command CommandFactory::makeStatsCommand(const std::string& params)
+{
+    return Command(new StatsCommand(context, params));
+}
+
+Command CommandFactory::makeTraceCommand(const std::string& params)
+{
+    return Command(new TraceCommand(context, params));
+}
+
 Command CommandFactory::makeMacroCommand(const std::string& expr)
 {
     // Create the three commands in sequence
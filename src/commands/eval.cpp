@@ -10,6 +10,6 @@ EvalCommand::EvalCommand(Context& context, std::string evalFormat)
 
 bool EvalCommand::execute()
 {
-    context.output() << context.evaluate(format) << std::endl;
+    context.output() << context.evaluate(format) << '\n';
     return true;
 }
@@ -0,0 +1,15 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "commands/load.h"
+#include "core/context.h"
+
+LoadCommand::LoadCommand(Context& context, std::string path)
+    : Command_Impl(context)
+    , path(std::move(path))
+{
+}
+
+bool LoadCommand::execute()
+{
+    context.load(path);
+    return true;
+}
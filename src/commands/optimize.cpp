@@ -0,0 +1,14 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "commands/optimize.h"
+#include "core/context.h"
+
+OptimizeCommand::OptimizeCommand(Context& context)
+    : Command_Impl(context)
+{
+}
+
+bool OptimizeCommand::execute()
+{
+    context.output() << "Removed " << context.optimize() << " nodes\n";
+    return true;
+}
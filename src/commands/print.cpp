@@ -12,6 +12,6 @@ PrintCommand::PrintCommand(Context& context, std::string format)
 bool PrintCommand::execute()
 {
     context.print(format);
-    context.output() << std::endl;
+    context.output() << '\n';
     return true;
 }
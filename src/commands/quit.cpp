@@ -1,7 +1,6 @@
 /* Copyright G. Hemingway @ 2022, All Rights Reserved */
 #include "commands/quit.h"
 #include "core/context.h"
-#include "core/reactor.h"
 
 QuitCommand::QuitCommand(Context& context)
     : Command_Impl(context)
@@ -11,7 +10,7 @@ QuitCommand::QuitCommand(Context& context)
 bool QuitCommand::execute()
 {
     context.output() << "Stopping now.  Have a great day...";
-    // Set reactor run flag to false
-    Reactor::instance()->endEventLoop();
+    context.output().flush();
+    // Whoever runs the command ends the session
     return false;
 }
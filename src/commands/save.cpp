@@ -0,0 +1,15 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "commands/save.h"
+#include "core/context.h"
+
+SaveCommand::SaveCommand(Context& context, std::string path)
+    : Command_Impl(context)
+    , path(std::move(path))
+{
+}
+
+bool SaveCommand::execute()
+{
+    context.save(path);
+    return true;
+}
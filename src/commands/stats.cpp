@@ -0,0 +1,15 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "commands/stats.h"
+#include "core/context.h"
+
+StatsCommand::StatsCommand(Context& context, std::string action)
+    : Command_Impl(context)
+    , action(std::move(action))
+{
+}
+
+bool StatsCommand::execute()
+{
+    context.stats(action);
+    return true;
+}
@@ -0,0 +1,15 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "commands/trace.h"
+#include "core/context.h"
+
+TraceCommand::TraceCommand(Context& context, std::string path)
+    : Command_Impl(context)
+    , path(std::move(path))
+{
+}
+
+bool TraceCommand::execute()
+{
+    context.trace(path);
+    return true;
+}
@@ -0,0 +1,57 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "core/acceptor.h"
+#include "core/event_handler.h"
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+Acceptor::Acceptor(const std::string& path, bool verbose, Reactor::Clock::duration idleTimeout)
+    : path(path)
+    , verbose(verbose)
+    , idleTimeout(idleTimeout)
+    , listener(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0))
+{
+    if (listener < 0)
+        throw std::runtime_error("Can't create a socket");
+
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        close(listener);
+        throw std::invalid_argument("Socket path is too long: " + path);
+    }
+    std::strcpy(address.sun_path, path.c_str());
+
+    unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+        || listen(listener, SOMAXCONN) < 0) {
+        close(listener);
+        throw std::runtime_error("Can't listen on " + path);
+    }
+}
+
+Acceptor::~Acceptor()
+{
+    close(listener);
+    unlink(path.c_str());
+}
+
+void Acceptor::handle()
+{
+    int connection = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+    // the client may have given up already
+    if (connection < 0)
+        return;
+    auto handler = EventHandler::makeHandler(verbose, connection, idleTimeout);
+    Reactor::instance()->registerHandler(handler);
+    // the client starts idling now
+    if (idleTimeout > Reactor::Clock::duration::zero())
+        Reactor::instance()->scheduleTimer(handler, idleTimeout);
+}
+
+int Acceptor::descriptor() const
+{
+    return listener;
+}
@@ -0,0 +1,82 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "core/allocation_stats.h"
+#include <cstdlib>
+#include <new>
+
+// Counts for each thread.  These are plain integers that need no
+// construction, so they are safe to use from operator new whenever it
+// is called, even while the thread is starting or exiting.
+static thread_local AllocationStats::Counts counts;
+
+AllocationStats::Counts AllocationStats::Counts::operator-(const Counts& rhs) const
+{
+    return { allocations - rhs.allocations, bytes - rhs.bytes, frees - rhs.frees,
+        created - rhs.created, destroyed - rhs.destroyed };
+}
+
+AllocationStats::Counts AllocationStats::current()
+{
+    return counts;
+}
+
+void AllocationStats::allocated(std::size_t bytes)
+{
+    ++counts.allocations;
+    counts.bytes += bytes;
+}
+
+void AllocationStats::freed()
+{
+    ++counts.frees;
+}
+
+void AllocationStats::created()
+{
+    ++counts.created;
+}
+
+void AllocationStats::destroyed()
+{
+    ++counts.destroyed;
+}
+
+#ifdef EXPRESSION_TREE_TRACK_ALLOCATIONS
+
+// The replacement global allocation functions.  The standard library's
+// own array, nothrow and sized versions all forward to these.
+
+void* operator new(std::size_t size)
+{
+    AllocationStats::allocated(size);
+    if (void* block = std::malloc(size == 0 ? 1 : size))
+        return block;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    AllocationStats::allocated(size);
+    auto align = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants a size that is a multiple of the alignment
+    if (void* block = std::aligned_alloc(align, (size + align - 1) / align * align))
+        return block;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept
+{
+    if (block) {
+        AllocationStats::freed();
+        std::free(block);
+    }
+}
+
+void operator delete(void* block, std::align_val_t) noexcept
+{
+    if (block) {
+        AllocationStats::freed();
+        std::free(block);
+    }
+}
+
+#endif // EXPRESSION_TREE_TRACK_ALLOCATIONS
@@ -0,0 +1,63 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "core/batch_processor.h"
+#include "commands/command.h"
+#include "commands/command_factory.h"
+#include "core/tracer.h"
+#include <iostream>
+
+BatchProcessor::BatchProcessor(std::istream& in, std::ostream& os, bool verbose)
+    : in(in)
+    , verbose(verbose)
+    , context(os)
+    , commandFactory(new CommandFactory(context))
+{
+}
+
+BatchProcessor::~BatchProcessor() = default;
+
+std::size_t BatchProcessor::run()
+{
+    // expressions are always parsed in-order
+    if (!verbose)
+        context.format("in-order");
+
+    std::string line;
+    std::size_t number = 0;
+    std::size_t errors = 0;
+
+    while (std::getline(in, line)) {
+        ++number;
+        // tolerate scripts with DOS line endings
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty())
+            continue;
+
+        try {
+            if (!process(line))
+                break;
+            continue;
+        } catch (ExpressionTree::InvalidIterator& e) {
+            std::cerr << "line " << number << ": ERROR: Bad traversal type (" << e.what() << ")\n";
+        } catch (State::InvalidState& e) {
+            std::cerr << "line " << number << ": ERROR: " << e.what() << "\n";
+        } catch (std::exception& e) {
+            std::cerr << "line " << number << ": ERROR: " << e.what() << "\n";
+        }
+        ++errors;
+    }
+
+    context.output().flush();
+    return errors;
+}
+
+bool BatchProcessor::process(const std::string& line)
+{
+    Tracer::Span span("command", "command");
+    if (verbose)
+        return commandFactory->makeCommand(line).execute();
+
+    context.makeTree(line);
+    context.output() << context.evaluate("post-order") << '\n';
+    return true;
+}
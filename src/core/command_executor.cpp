@@ -0,0 +1,80 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "core/command_executor.h"
+#include "core/event_handler.h"
+#include <cstdint>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+CommandExecutor* CommandExecutor::inst = nullptr;
+
+CommandExecutor* CommandExecutor::instance()
+{
+    return inst;
+}
+
+CommandExecutor::CommandExecutor(std::size_t threads)
+    : jobs(queueCapacity)
+    , wakeup(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+{
+    if (wakeup < 0)
+        throw std::runtime_error("Can't create the executor's eventfd");
+    for (std::size_t i = 0; i < threads; ++i)
+        workers.emplace_back(&CommandExecutor::work, this);
+    inst = this;
+}
+
+CommandExecutor::~CommandExecutor()
+{
+    inst = nullptr;
+    // commands are only submitted from the Reactor's thread, which is
+    // the one tearing us down, so nothing is queued after the clear.
+    jobs.clear();
+    jobs.close();
+    for (auto& worker : workers)
+        worker.join();
+    close(wakeup);
+}
+
+void CommandExecutor::submit(EventHandler* session, const Command& command)
+{
+    jobs.push({ session, command, true, nullptr });
+}
+
+void CommandExecutor::work()
+{
+    Job job { nullptr, Command(nullptr), true, nullptr };
+    while (jobs.pop(job)) {
+        try {
+            job.keepGoing = job.session->executeCommand(job.command);
+        } catch (...) {
+            job.error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(completedLock);
+            completed.push_back(std::move(job));
+        }
+        std::uint64_t one = 1;
+        (void)write(wakeup, &one, sizeof(one));
+    }
+}
+
+void CommandExecutor::handle()
+{
+    std::uint64_t count;
+    (void)read(wakeup, &count, sizeof(count));
+
+    std::vector<Job> done;
+    {
+        std::lock_guard<std::mutex> guard(completedLock);
+        done.swap(completed);
+    }
+    for (auto& job : done)
+        job.session->completed(job.command, job.keepGoing, job.error);
+}
+
+int CommandExecutor::descriptor() const
+{
+    return wakeup;
+}
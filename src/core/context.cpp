@@ -1,10 +1,21 @@
 /* Copyright G. Hemingway @ 2022, All Rights Reserved */
 #include "core/context.h"
+#include "core/latency_stats.h"
+#include "core/options.h"
+#include "core/tracer.h"
+#include "core/work_stealing_pool.h"
 #include <algorithm>
+#include <fstream>
+#include <stdexcept>
 
-Context::Context(std::ostream& os)
+// Number of parsed expressions the cache holds by default.
+static constexpr std::size_t defaultCacheCapacity = 64;
+
+Context::Context(std::ostream& os, bool files)
     : treeState(new UninitializedState(*this))
+    , cached(defaultCacheCapacity)
     , isFormatted(false)
+    , files(files)
     , os(os)
 {
 }
@@ -22,23 +33,36 @@ void Context::format(const std::string& newFormat)
 
 void Context::makeTree(const std::string& expression)
 {
+    LatencyStats::Timer timer(LatencyStats::Phase::MakeTree);
+    Tracer::Span span("expr", "command");
     treeState->makeTree(expression);
     addCommand("expr " + expression);
 }
 
 void Context::print(const std::string& format)
 {
+    LatencyStats::Timer timer(LatencyStats::Phase::Print);
+    Tracer::Span span("print", "command");
     treeState->print(format, os);
     addCommand("print " + format);
 }
 
 int Context::evaluate(const std::string& format)
 {
+    LatencyStats::Timer timer(LatencyStats::Phase::Evaluate);
+    Tracer::Span span("eval", "command");
     auto tmp = treeState->evaluate(format);
     addCommand("eval " + format);
     return tmp;
 }
 
+std::size_t Context::optimize()
+{
+    auto removed = treeState->optimize();
+    addCommand("optimize");
+    return removed;
+}
+
 void Context::set(const std::string& kvPair)
 {
     std::string input = kvPair;
@@ -58,6 +82,8 @@ void Context::set(const std::string& kvPair)
             std::string value = input.substr(pos + 1);
 
             variables.set(key, atoi(value.c_str()));
+            if (incrementalEvaluator)
+                incrementalEvaluator->invalidate(variables.find(key));
         } else
             throw std::domain_error("Must be in the form key=value");
     } else
@@ -68,14 +94,14 @@ void Context::set(const std::string& kvPair)
 
 void Context::get(const std::string& var)
 {
-    os << variables.get(var) << std::endl;
+    os << variables.get(var) << '\n';
     addCommand("get " + var);
 }
 
 void Context::list()
 {
     variables.print(os);
-    os << std::endl;
+    os << '\n';
     addCommand("list");
 }
 
@@ -94,9 +120,132 @@ ExpressionTree& Context::tree()
     return expTree;
 }
 
-void Context::tree(const ExpressionTree& tree)
+void Context::tree(
+    const ExpressionTree& tree, std::shared_ptr<const Bytecode> program, std::string cacheKey)
 {
     expTree = tree;
+    compiled = std::move(program);
+    treeKey = std::move(cacheKey);
+    incrementalEvaluator.reset();
+    parallelEvaluator.reset();
+    variants.reset();
+}
+
+const Bytecode& Context::program()
+{
+    if (!compiled) {
+        compiled = std::make_shared<const Bytecode>(expTree.compile());
+        if (!treeKey.empty())
+            cached.compiled(treeKey, expTree, compiled);
+    }
+    return *compiled;
+}
+
+IncrementalEvaluator& Context::incremental()
+{
+    if (!incrementalEvaluator)
+        incrementalEvaluator = std::make_unique<IncrementalEvaluator>(expTree);
+    return *incrementalEvaluator;
+}
+
+const VariantTree& Context::variantTree()
+{
+    if (!variants)
+        variants = std::make_unique<const VariantTree>(expTree);
+    return *variants;
+}
+
+const ParallelEvaluator& Context::parallel()
+{
+    if (!parallelEvaluator) {
+        auto pool = WorkStealingPool::instance();
+        if (!pool)
+            throw std::logic_error("No thread pool to evaluate on");
+        parallelEvaluator = std::make_unique<const ParallelEvaluator>(variantTree(), *pool);
+    }
+    return *parallelEvaluator;
+}
+
+void Context::cache(const std::string& capacity)
+{
+    if (!capacity.empty()) {
+        std::size_t end = 0;
+        long value = -1;
+        try {
+            value = std::stol(capacity, &end);
+        } catch (std::exception&) {
+        }
+        if (value < 0 || end != capacity.length())
+            throw std::invalid_argument("Cache capacity must be a non-negative number");
+        cached.capacity(static_cast<std::size_t>(value));
+    }
+    cached.print(os);
+}
+
+ExpressionCache& Context::expressions()
+{
+    return cached;
+}
+
+void Context::save(const std::string& path)
+{
+    if (!files)
+        throw std::logic_error("Save is not available to remote clients");
+    if (path.empty())
+        throw std::invalid_argument("Save needs a file name");
+
+    TreeWriter writer(variables);
+    cached.save(writer);
+    std::ofstream file(path, std::ios::binary);
+    writer.write(file);
+    file.close();
+    if (!file)
+        throw std::runtime_error("Can't write " + path);
+    os << "Saved " << writer.size() << " expressions to " << path << '\n';
+}
+
+void Context::load(const std::string& path)
+{
+    if (!files)
+        throw std::logic_error("Load is not available to remote clients");
+    if (path.empty())
+        throw std::invalid_argument("Load needs a file name");
+
+    archived = std::make_unique<const TreeArchive>(path, variables);
+    os << "Loaded " << archived->size() << " expressions from " << path << '\n';
+}
+
+void Context::stats(const std::string& action)
+{
+    bool reset = action == "reset";
+    if (!reset && !action.empty())
+        throw std::invalid_argument("Stats only takes reset as a parameter");
+
+    auto latencies = LatencyStats::instance();
+    latencies->print(os);
+    if (reset)
+        latencies->reset();
+}
+
+void Context::trace(const std::string& path)
+{
+    auto tracer = Tracer::instance();
+    if (!tracer->enabled()) {
+        os << "Tracing is off (start with -x file)\n";
+        return;
+    }
+
+    // a client can only have the trace written where the server's -x put it
+    if (!files && !path.empty())
+        throw std::logic_error("Trace to a file is not available to remote clients");
+    const auto& file = path.empty() ? Options::instance()->trace() : path;
+    auto count = tracer->write(file);
+    os << "Wrote " << count << " trace events to " << file << '\n';
+}
+
+const TreeArchive* Context::archive() const
+{
+    return archived.get();
 }
 
 VariableMap& Context::getVariables()
@@ -109,7 +258,7 @@ bool Context::formatted() const
     return isFormatted;
 }
 
-std::ostream& Context::output() const
+OutputSink& Context::output()
 {
     return os;
 }
@@ -123,7 +272,7 @@ void Context::history()
 {
     for (uint32_t i = 1; i < historyQ.size() + 1; ++i) {
         auto tmp = historyQ.front();
-        os << i << ") " << tmp << std::endl;
+        os << i << ") " << tmp << '\n';
         historyQ.pop();
         historyQ.push(tmp);
     }
@@ -0,0 +1,71 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "core/descriptor_stream.h"
+#include <cerrno>
+#include <sys/socket.h>
+
+DescriptorStream::DescriptorStream(int socket)
+    : std::ostream(nullptr)
+    , buffer(socket)
+{
+    rdbuf(&buffer);
+}
+
+bool DescriptorStream::drain()
+{
+    return buffer.drain();
+}
+
+std::size_t DescriptorStream::backlog()
+{
+    return buffer.backlog();
+}
+
+DescriptorStream::Buffer::Buffer(int socket)
+    : socket(socket)
+    , sent(0)
+{
+}
+
+DescriptorStream::Buffer::int_type DescriptorStream::Buffer::overflow(int_type c)
+{
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+        return traits_type::not_eof(c);
+    char ch = traits_type::to_char_type(c);
+    return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+}
+
+// queue the output for drain() to send
+std::streamsize DescriptorStream::Buffer::xsputn(const char* data, std::streamsize count)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    queued.append(data, static_cast<std::size_t>(count));
+    return count;
+}
+
+// send until the socket's buffer is full, retrying after interrupts
+bool DescriptorStream::Buffer::drain()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    while (sent < queued.size()) {
+        auto result = send(
+            socket, queued.data() + sent, queued.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (result < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return false;
+            // the peer is gone, so nobody wants the rest
+            break;
+        }
+        sent += static_cast<std::size_t>(result);
+    }
+    queued.clear();
+    sent = 0;
+    return true;
+}
+
+std::size_t DescriptorStream::Buffer::backlog()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return queued.size() - sent;
+}
@@ -2,56 +2,276 @@
 #include "core/event_handler.h"
 #include "commands/command.h"
 #include "commands/command_factory.h"
+#include "core/command_executor.h"
+#include "core/latency_stats.h"
+#include "core/tracer.h"
+#include <cerrno>
 #include <iostream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Most input read in one go.
+static constexpr std::size_t readSize = 4096;
 
 EventHandler* EventHandler::makeHandler(bool verbose, std::ostream& os)
 {
-    return verbose ? static_cast<EventHandler*>(new VerboseHandler(os))
-                   : static_cast<EventHandler*>(new MacroHandler(os));
+    EventHandler* handler = verbose ? static_cast<EventHandler*>(new VerboseHandler(os))
+                                    : static_cast<EventHandler*>(new MacroHandler(os));
+    handler->promptUser();
+    return handler;
+}
+
+EventHandler* EventHandler::makeHandler(
+    bool verbose, int socket, Reactor::Clock::duration idleTimeout)
+{
+    EventHandler* handler = verbose
+        ? static_cast<EventHandler*>(new VerboseHandler(socket, idleTimeout))
+        : static_cast<EventHandler*>(new MacroHandler(socket, idleTimeout));
+    handler->promptUser();
+    // a new socket has room for the first prompt
+    handler->clientStream->drain();
+    return handler;
 }
 
 EventHandler::EventHandler(std::ostream& os)
-    : context(os)
+    : input(STDIN_FILENO)
+    , connection(false)
+    , busy(false)
+    , ended(false)
+    , finished(false)
+    , reading(true)
+    , writing(false)
+    , idleTimeout(Reactor::Clock::duration::zero())
+    , lastActive(Reactor::Clock::now())
+    , errors(std::cerr)
+    , context(os)
+    , commandFactory(new CommandFactory(context))
+    , lastValidCommand(commandFactory->makeNullCommand(""))
+{
+}
+
+EventHandler::EventHandler(int socket, Reactor::Clock::duration idleTimeout)
+    : input(socket)
+    , connection(true)
+    , busy(false)
+    , ended(false)
+    , finished(false)
+    , reading(true)
+    , writing(false)
+    , idleTimeout(idleTimeout)
+    , lastActive(Reactor::Clock::now())
+    , clientStream(new DescriptorStream(socket))
+    , errors(*clientStream)
+    , context(*clientStream, false)
     , commandFactory(new CommandFactory(context))
     , lastValidCommand(commandFactory->makeNullCommand(""))
 {
 }
 
+EventHandler::~EventHandler()
+{
+    // the context's output has to reach the client before it's closed
+    context.output().flush();
+    delete commandFactory;
+    if (connection) {
+        clientStream->drain();
+        close(input);
+    }
+}
+
 void EventHandler::handle()
 {
-    // Step 1) Prompt User
-    promptUser();
-    std::string input;
-    // Step 2) Get user input (error getting it shuts down application immediately)
-    if (!getInput(input))
-        Reactor::instance()->endEventLoop();
+    // Step 1) Get user input (the end of it, or an error getting it, ends the session)
+    bool open = getInput();
+    lastActive = Reactor::Clock::now();
+
+    std::string::size_type start = 0;
+    for (auto end = pending.find('\n'); end != std::string::npos;
+         end = pending.find('\n', start)) {
+        lines.push_back(pending.substr(start, end - start));
+        start = end + 1;
+        if (!lines.back().empty() && lines.back().back() == '\r')
+            lines.back().pop_back();
+    }
+    pending.erase(0, start);
 
+    if (!open) {
+        // a last line without a newline still counts, and then the end
+        // of the input quits just as an empty line does
+        if (!pending.empty())
+            lines.push_back(std::move(pending));
+        pending.clear();
+        lines.emplace_back();
+        ended = true;
+    }
+
+    // Steps 2-4) Run the lines
+    runPending();
+    update();
+}
+
+void EventHandler::handleOutput()
+{
+    update();
+}
+
+void EventHandler::handleTimeout()
+{
+    if (finished)
+        return;
+
+    // a client waiting on its commands or their output isn't idle
+    auto idle = Reactor::Clock::now() - lastActive;
+    if (busy || writing || !lines.empty() || idle < idleTimeout) {
+        auto left = busy || writing || !lines.empty() ? idleTimeout : idleTimeout - idle;
+        Reactor::instance()->scheduleTimer(this, left);
+        return;
+    }
+
+    errors << "\nClosing the connection after idling for "
+           << std::chrono::duration_cast<std::chrono::seconds>(idleTimeout).count()
+           << " seconds\n";
+    finish();
+    update();
+}
+
+void EventHandler::runPending()
+{
+    while (!busy && !lines.empty()) {
+        auto line = std::move(lines.front());
+        lines.pop_front();
+        if (!process(line)) {
+            finish();
+            return;
+        }
+    }
+}
+
+void EventHandler::update()
+{
+    auto reactor = Reactor::instance();
+    bool sent = !clientStream || clientStream->drain();
+    if (finished) {
+        if (!connection)
+            return;
+        if (sent) {
+            reactor->removeHandler(this);
+            return;
+        }
+    }
+
+    bool read = !finished && !ended && lines.size() < maxBacklog
+        && (!clientStream || clientStream->backlog() < maxOutput);
+    if (read != reading) {
+        if (read)
+            reactor->resumeHandler(this);
+        else
+            reactor->suspendHandler(this);
+        reading = read;
+    }
+    if (sent == writing) {
+        reactor->watchOutput(this, !sent);
+        writing = !sent;
+    }
+}
+
+int EventHandler::descriptor() const
+{
+    return input;
+}
+
+bool EventHandler::process(const std::string& line)
+{
     try {
-        // Step 3) Make a command
-        Command command
-            = input.empty() ? commandFactory->makeQuitCommand(input) : makeCommand(input);
-        // Step 4) Execute command
-        executeCommand(command);
+        // Step 2) Make a command
+        Command command = line.empty() ? commandFactory->makeQuitCommand(line) : makeCommand(line);
+        // Step 3) Execute command, on a worker thread if there are any
+        if (auto executor = CommandExecutor::instance()) {
+            busy = true;
+            executor->submit(this, command);
+            return true;
+        }
+        if (!executeCommand(command))
+            return false;
         lastValidCommand = command;
+    } catch (std::exception&) {
+        report(std::current_exception());
+    }
+
+    // Step 4) Prompt for the next command
+    promptUser();
+    return true;
+}
+
+void EventHandler::completed(const Command& command, bool keepGoing, std::exception_ptr error)
+{
+    busy = false;
+    lastActive = Reactor::Clock::now();
+    if (error)
+        report(error);
+    else if (!keepGoing) {
+        finish();
+        update();
+        return;
+    } else
+        lastValidCommand = command;
+
+    // Step 4) Prompt for the next command, and carry on with the others
+    promptUser();
+    runPending();
+    update();
+}
+
+void EventHandler::report(std::exception_ptr error)
+{
+    // anything the command printed comes first
+    context.output().flush();
+    try {
+        std::rethrow_exception(error);
     } catch (ExpressionTree::InvalidIterator& e) {
-        std::cerr << "\nERROR: Bad traversal type (" << e.what() << ")\n";
+        errors << "\nERROR: Bad traversal type (" << e.what() << ")\n";
     } catch (State::InvalidState& e) {
-        std::cerr << "\nERROR: " << e.what() << std::endl;
+        errors << "\nERROR: " << e.what() << std::endl;
     } catch (std::logic_error& e) {
-        std::cerr << e.what() << std::endl;
+        errors << e.what() << std::endl;
     } catch (std::invalid_argument e) {
-        std::cerr << "\nERROR: Invalid parameter (" << e.what() << ")\n";
+        errors << "\nERROR: Invalid parameter (" << e.what() << ")\n";
+    } catch (std::exception& e) {
+        errors << "\nERROR: " << e.what() << std::endl;
     }
 }
 
-bool EventHandler::getInput(std::string& input)
+void EventHandler::finish()
 {
-    std::getline(std::cin, input);
-    return !std::cin.fail();
+    // a connection is removed by update() once its output is all sent
+    finished = true;
+    if (!connection)
+        Reactor::instance()->endEventLoop();
+}
+
+bool EventHandler::getInput()
+{
+    LatencyStats::Timer timer(LatencyStats::Phase::Input);
+    char chunk[readSize];
+    while (true) {
+        // sockets are never waited on here, in case the input is gone
+        // by the time we get to it
+        auto count = connection ? recv(input, chunk, sizeof(chunk), MSG_DONTWAIT)
+                                : read(input, chunk, sizeof(chunk));
+        if (count > 0) {
+            pending.append(chunk, static_cast<std::size_t>(count));
+            return true;
+        }
+        if (count < 0 && errno == EINTR)
+            continue;
+        return count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
 }
 
 bool EventHandler::executeCommand(Command command)
 {
+    LatencyStats::Timer timer(LatencyStats::Phase::Execute);
+    Tracer::Span span("command", "command");
     return command.execute();
 }
 
@@ -60,8 +280,14 @@ VerboseHandler::VerboseHandler(std::ostream& os)
 {
 }
 
+VerboseHandler::VerboseHandler(int socket, Reactor::Clock::duration idleTimeout)
+    : EventHandler(socket, idleTimeout)
+{
+}
+
 void VerboseHandler::promptUser()
 {
+    LatencyStats::Timer timer(LatencyStats::Phase::Prompt);
     context.state()->printValidCommands();
     context.output() << "> ";
     context.output().flush();
@@ -69,6 +295,7 @@ void VerboseHandler::promptUser()
 
 Command VerboseHandler::makeCommand(const std::string& input)
 {
+    LatencyStats::Timer timer(LatencyStats::Phase::MakeCommand);
     return commandFactory->makeCommand(input);
 }
 
@@ -77,13 +304,20 @@ MacroHandler::MacroHandler(std::ostream& os)
 {
 }
 
+MacroHandler::MacroHandler(int socket, Reactor::Clock::duration idleTimeout)
+    : EventHandler(socket, idleTimeout)
+{
+}
+
 void MacroHandler::promptUser()
 {
+    LatencyStats::Timer timer(LatencyStats::Phase::Prompt);
     context.output() << "> ";
     context.output().flush();
 }
 
 Command MacroHandler::makeCommand(const std::string& input)
 {
+    LatencyStats::Timer timer(LatencyStats::Phase::MakeCommand);
     return commandFactory->makeMacroCommand(input);
 }
@@ -0,0 +1,114 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "core/expression_cache.h"
+#include "interpreter/lexer.h"
+
+// Ctor
+ExpressionCache::ExpressionCache(std::size_t capacity)
+    : maxEntries(capacity)
+    , hits(0)
+    , misses(0)
+{
+}
+
+// normalize the text of an expression
+std::string ExpressionCache::normalize(std::string_view expression)
+{
+    std::string key;
+    key.reserve(expression.length());
+
+    bool space = false;
+    for (char c : expression) {
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            space = true;
+            continue;
+        }
+        // "1 2" and "12" must not share a key
+        if (space && !key.empty() && Lexer::isAlphanumeric(key.back())
+            && Lexer::isAlphanumeric(c))
+            key += ' ';
+        key += c;
+        space = false;
+    }
+
+    return key;
+}
+
+// look up an entry
+const ExpressionCache::Entry* ExpressionCache::find(const std::string& key)
+{
+    auto iter = index.find(key);
+    if (iter == index.end()) {
+        ++misses;
+        return nullptr;
+    }
+
+    ++hits;
+    // move the entry to the front without invalidating any iterators
+    entries.splice(entries.begin(), entries, iter->second);
+    return &iter->second->second;
+}
+
+// add an entry
+void ExpressionCache::insert(const std::string& key, Entry entry)
+{
+    if (maxEntries == 0)
+        return;
+
+    auto iter = index.find(key);
+    if (iter != index.end()) {
+        iter->second->second = std::move(entry);
+        entries.splice(entries.begin(), entries, iter->second);
+        return;
+    }
+
+    evict(maxEntries - 1);
+    entries.emplace_front(key, std::move(entry));
+    // the key lives in the list node, which never moves
+    index.emplace(entries.front().first, entries.begin());
+}
+
+// add a compiled program to an entry
+void ExpressionCache::compiled(
+    const std::string& key, const ExpressionTree& tree, std::shared_ptr<const Bytecode> program)
+{
+    auto iter = index.find(key);
+    if (iter != index.end() && iter->second->second.tree == tree)
+        iter->second->second.program = std::move(program);
+}
+
+// return the capacity
+std::size_t ExpressionCache::capacity() const
+{
+    return maxEntries;
+}
+
+// change the capacity
+void ExpressionCache::capacity(std::size_t capacity)
+{
+    maxEntries = capacity;
+    evict(maxEntries);
+}
+
+// add the entries in the order that inserting them again would leave
+// them in
+void ExpressionCache::save(TreeWriter& writer) const
+{
+    for (auto iter = entries.rbegin(); iter != entries.rend(); ++iter)
+        writer.add(iter->second.tree, iter->first);
+}
+
+// print the statistics
+void ExpressionCache::print(OutputSink& os) const
+{
+    os << "size=" << entries.size() << " capacity=" << maxEntries << " hits=" << hits
+       << " misses=" << misses << '\n';
+}
+
+// drop least recently used entries
+void ExpressionCache::evict(std::size_t limit)
+{
+    while (entries.size() > limit) {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
@@ -0,0 +1,247 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "core/latency_stats.h"
+#include <algorithm>
+#include <cstdio>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+LatencyHistogram::LatencyHistogram()
+    : sum(0)
+    , largest(0)
+{
+    for (auto& count : buckets)
+        count.store(0, std::memory_order_relaxed);
+}
+
+// The first four buckets hold 0 to 3 exactly; after that the bucket is
+// the position of the top bit and the two bits below it.
+std::size_t LatencyHistogram::bucket(std::uint64_t latency)
+{
+    if (latency < (1u << subBits))
+        return static_cast<std::size_t>(latency);
+    int top = 63 - __builtin_clzll(latency);
+    auto sub = (latency >> (top - subBits)) & ((1u << subBits) - 1);
+    return (static_cast<std::size_t>(top - subBits + 1) << subBits) + sub;
+}
+
+std::uint64_t LatencyHistogram::upperBound(std::size_t bucket)
+{
+    if (bucket < (1u << subBits))
+        return bucket;
+    int shift = static_cast<int>(bucket >> subBits) - 1;
+    std::uint64_t lower = ((1ull << subBits) + (bucket & ((1u << subBits) - 1))) << shift;
+    return lower + ((1ull << shift) - 1);
+}
+
+void LatencyHistogram::record(std::uint64_t latency)
+{
+    buckets[bucket(latency)].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(latency, std::memory_order_relaxed);
+    auto seen = largest.load(std::memory_order_relaxed);
+    while (latency > seen
+        && !largest.compare_exchange_weak(seen, latency, std::memory_order_relaxed))
+        continue;
+}
+
+// the total is only needed when printing, so it isn't kept separately
+std::uint64_t LatencyHistogram::count() const
+{
+    std::uint64_t total = 0;
+    for (const auto& count : buckets)
+        total += count.load(std::memory_order_relaxed);
+    return total;
+}
+
+double LatencyHistogram::mean() const
+{
+    auto counted = count();
+    return counted == 0 ? 0 : static_cast<double>(sum.load(std::memory_order_relaxed)) / counted;
+}
+
+std::uint64_t LatencyHistogram::max() const
+{
+    return largest.load(std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyHistogram::quantile(double q) const
+{
+    auto rank = static_cast<std::uint64_t>(q * static_cast<double>(count()));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < bucketCount; ++i) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen > rank)
+            // never claim more than the largest latency seen
+            return std::min(upperBound(i), max());
+    }
+    return max();
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto& count : buckets)
+        count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    largest.store(0, std::memory_order_relaxed);
+}
+
+LatencyStats::Timer::Timer(Phase phase)
+    : phase(phase)
+    , timing(LatencyStats::instance()->sample(phase))
+    , start(0)
+    , allocations()
+{
+    if (AllocationStats::tracking)
+        allocations = AllocationStats::current();
+    if (timing)
+        start = LatencyStats::ticks();
+}
+
+LatencyStats::Timer::~Timer()
+{
+    if (timing)
+        LatencyStats::instance()->record(phase, LatencyStats::ticks() - start);
+    if (AllocationStats::tracking)
+        LatencyStats::instance()->record(phase, AllocationStats::current() - allocations);
+}
+
+LatencyStats* LatencyStats::inst = nullptr;
+
+LatencyStats::LatencyStats()
+    : sampling(0)
+    , startTicks(ticks())
+    , startTime(std::chrono::steady_clock::now())
+{
+    reset();
+}
+
+LatencyStats::~LatencyStats()
+{
+    inst = nullptr;
+}
+
+LatencyStats* LatencyStats::instance()
+{
+    if (LatencyStats::inst == nullptr)
+        LatencyStats::inst = new LatencyStats;
+    return LatencyStats::inst;
+}
+
+std::uint64_t LatencyStats::ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch())
+                                          .count());
+#endif
+}
+
+void LatencyStats::enable(std::size_t every)
+{
+    startTicks = ticks();
+    startTime = std::chrono::steady_clock::now();
+    sampling.store(static_cast<std::uint32_t>(every), std::memory_order_relaxed);
+}
+
+bool LatencyStats::enabled() const
+{
+    return sampling.load(std::memory_order_relaxed) > 0;
+}
+
+// Runs are counted separately for each phase, so phases that always run
+// together can't keep missing each other, and on each thread, so the
+// count needn't be atomic.
+bool LatencyStats::sample(Phase phase) const
+{
+    auto every = sampling.load(std::memory_order_relaxed);
+    if (every == 0)
+        return false;
+    thread_local std::array<std::uint32_t, static_cast<std::size_t>(Phase::Count)> skipped {};
+    auto& count = skipped[static_cast<std::size_t>(phase)];
+    if (++count < every)
+        return false;
+    count = 0;
+    return true;
+}
+
+void LatencyStats::record(Phase phase, std::uint64_t latency)
+{
+    histograms[static_cast<std::size_t>(phase)].record(latency);
+}
+
+void LatencyStats::record(Phase phase, const AllocationStats::Counts& counts)
+{
+    auto& totals = allocated[static_cast<std::size_t>(phase)];
+    totals.runs.fetch_add(1, std::memory_order_relaxed);
+    totals.allocations.fetch_add(counts.allocations, std::memory_order_relaxed);
+    totals.bytes.fetch_add(counts.bytes, std::memory_order_relaxed);
+    totals.created.fetch_add(counts.created, std::memory_order_relaxed);
+}
+
+// Names of the phases as printed.
+static const char* const phaseNames[] = { "input", "command", "execute", "prompt", "expr",
+    "eval", "print" };
+
+void LatencyStats::print(OutputSink& os) const
+{
+    auto every = sampling.load(std::memory_order_relaxed);
+    if (every == 0)
+        os << "Latency statistics are off (start with -m)\n";
+    else if (every > 1)
+        os << "Timing one run in " << every << " of each phase\n";
+    os << "phase        count     mean us      p50 us      p99 us     p999 us      max us\n";
+
+    // microseconds per tick, going by how far each clock has moved
+    auto elapsed = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - startTime);
+    auto ticked = ticks() - startTicks;
+    double scale = ticked == 0 ? 0 : elapsed.count() / static_cast<double>(ticked);
+
+    char line[128];
+    for (std::size_t i = 0; i < histograms.size(); ++i) {
+        const auto& histogram = histograms[i];
+        if (histogram.count() == 0)
+            continue;
+        std::snprintf(line, sizeof(line), "%-8s %9llu %11.2f %11.2f %11.2f %11.2f %11.2f\n",
+            phaseNames[i], static_cast<unsigned long long>(histogram.count()), histogram.mean() * scale,
+            histogram.quantile(0.5) * scale, histogram.quantile(0.99) * scale,
+            histogram.quantile(0.999) * scale, histogram.max() * scale);
+        os << line;
+    }
+
+    if (AllocationStats::tracking)
+        printAllocations(os);
+}
+
+void LatencyStats::printAllocations(OutputSink& os) const
+{
+    os << "phase         runs  allocs/run   bytes/run objects/run\n";
+    char line[128];
+    for (std::size_t i = 0; i < allocated.size(); ++i) {
+        const auto& totals = allocated[i];
+        auto runs = totals.runs.load(std::memory_order_relaxed);
+        if (runs == 0)
+            continue;
+        auto perRun = [runs](const std::atomic<std::uint64_t>& total) {
+            return static_cast<double>(total.load(std::memory_order_relaxed)) / runs;
+        };
+        std::snprintf(line, sizeof(line), "%-8s %9llu %11.2f %11.1f %11.2f\n", phaseNames[i],
+            static_cast<unsigned long long>(runs), perRun(totals.allocations),
+            perRun(totals.bytes), perRun(totals.created));
+        os << line;
+    }
+}
+
+void LatencyStats::reset()
+{
+    for (auto& histogram : histograms)
+        histogram.reset();
+    for (auto& totals : allocated) {
+        totals.runs.store(0, std::memory_order_relaxed);
+        totals.allocations.store(0, std::memory_order_relaxed);
+        totals.bytes.store(0, std::memory_order_relaxed);
+        totals.created.store(0, std::memory_order_relaxed);
+    }
+}
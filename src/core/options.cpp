@@ -1,6 +1,7 @@
 /* Copyright G. Hemingway @ 2022, All Rights Reserved */
 #include "core/options.h"
 #include "core/getopt.h"
+#include <algorithm>
 #include <iostream>
 
 // Initialize the singleton.
@@ -17,6 +18,16 @@ Options* Options::instance()
 // Ctor
 Options::Options()
     : isVerbose(false)
+    , useArena(false)
+    , usePratt(false)
+    , useSharing(false)
+    , useOptimizer(false)
+    , useIncremental(false)
+    , useVariant(false)
+    , threadCount(0)
+    , workerCount(0)
+    , idleSeconds(0)
+    , statsEvery(0)
 {
 }
 
@@ -37,13 +48,78 @@ bool Options::verbose() const
     return isVerbose;
 }
 
+bool Options::arena() const
+{
+    return useArena;
+}
+
+bool Options::pratt() const
+{
+    return usePratt;
+}
+
+bool Options::share() const
+{
+    return useSharing;
+}
+
+bool Options::optimize() const
+{
+    return useOptimizer;
+}
+
+bool Options::incremental() const
+{
+    return useIncremental;
+}
+
+bool Options::variant() const
+{
+    return useVariant;
+}
+
+std::size_t Options::stats() const
+{
+    return statsEvery;
+}
+
+std::size_t Options::threads() const
+{
+    return threadCount;
+}
+
+const std::string& Options::script() const
+{
+    return scriptPath;
+}
+
+const std::string& Options::server() const
+{
+    return socketPath;
+}
+
+std::size_t Options::workers() const
+{
+    return workerCount;
+}
+
+std::size_t Options::idleTimeout() const
+{
+    return idleSeconds;
+}
+
+const std::string& Options::trace() const
+{
+    return tracePath;
+}
+
 // Parse the command line arguments.
 bool Options::parseArgs(int argc, char* argv[])
 {
     // set exe_ to the first arg.
     execStr = parsing::getfilename(argv[0]);
     pathStr = parsing::getpath(argv[0]);
-    char opts[] = "h?v";
+    char opts[] = "h?vapsoidj:f:u:w:t:m:x:";
 
     for (int c; (c = parsing::getopt(argc, argv, opts)) != EOF;)
         switch (c) {
@@ -51,6 +127,45 @@ bool Options::parseArgs(int argc, char* argv[])
         case 'v':
             isVerbose = true;
             break;
+        case 'a':
+            useArena = true;
+            break;
+        case 'p':
+            usePratt = true;
+            break;
+        case 's':
+            useSharing = true;
+            break;
+        case 'o':
+            useOptimizer = true;
+            break;
+        case 'i':
+            useIncremental = true;
+            break;
+        case 'd':
+            useVariant = true;
+            break;
+        case 'j':
+            threadCount = static_cast<std::size_t>(std::max(atoi(parsing::optarg), 0));
+            break;
+        case 'f':
+            scriptPath = parsing::optarg;
+            break;
+        case 'u':
+            socketPath = parsing::optarg;
+            break;
+        case 'w':
+            workerCount = static_cast<std::size_t>(std::max(atoi(parsing::optarg), 0));
+            break;
+        case 't':
+            idleSeconds = static_cast<std::size_t>(std::max(atoi(parsing::optarg), 0));
+            break;
+        case 'm':
+            statsEvery = static_cast<std::size_t>(std::max(atoi(parsing::optarg), 0));
+            break;
+        case 'x':
+            tracePath = parsing::optarg;
+            break;
         case 'h':
         case '?':
             printUsage();
@@ -66,9 +181,27 @@ bool Options::parseArgs(int argc, char* argv[])
 void Options::printUsage()
 {
     std::cout << std::endl << "Help Invoked on " << pathStr + execStr << std::endl << std::endl;
-    std::cout << "Usage: " << execStr << " [-h|-v]" << std::endl
+    std::cout << "Usage: " << execStr << " [-h|-v|-a|-p|-s|-o|-i|-d|-j threads|-f file|-u socket|-w workers|-t seconds|-m runs|-x file]" << std::endl
               << std::endl
               << "  -h: invoke help" << std::endl
               << "  -v: enter verbose mode" << std::endl
+              << "  -a: build expression trees in a flat arena" << std::endl
+              << "  -p: parse expressions in a single pass (implies -a)" << std::endl
+              << "  -s: share repeated subexpressions (implies -a)" << std::endl
+              << "  -o: simplify expressions as they are parsed" << std::endl
+              << "  -i: only recompute what changed since the last eval" << std::endl
+              << "  -d: evaluate and print without virtual dispatch" << std::endl
+              << "  -j: evaluate large expressions on this many threads" << std::endl
+              << "  -f: run a script of expressions (commands with -v) without" << std::endl
+              << "      prompting; use - to read it from the standard input" << std::endl
+              << "  -u: serve clients on this Unix domain socket (commands with -v)"
+              << std::endl
+              << "  -w: execute commands on this many worker threads" << std::endl
+              << "  -t: disconnect clients idle for this many seconds" << std::endl
+              << "  -m: time one run in this many of each phase, for the stats command"
+              << std::endl
+              << "  -x: trace the most recent commands and write them to this file on exit,"
+              << std::endl
+              << "      as Chrome trace events" << std::endl
               << std::endl;
 }
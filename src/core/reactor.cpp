@@ -1,36 +1,32 @@
 /* Copyright G. Hemingway @ 2022, All Rights Reserved */
 #include "core/reactor.h"
-#include "core/event_handler.h"
 #include <algorithm>
-#include <functional>
+#include <cerrno>
+#include <climits>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+// Most events handled in one round of dispatching.
+static constexpr int maxEvents = 64;
 
 Reactor* Reactor::inst = nullptr;
 
 Reactor::Reactor()
-    : runningEventLoop(true)
-{
-}
-
-/**
- * @class Remove_Handler_Adapter
- * @brief This functor implements the Adapter pattern so an @a
- *        Reactor's remove_input_handler() method can be called
- *        with the appropriate Event_Handler in the context of the
- *        std:for_each() algorithm.
- */
-struct RemoveHandlerAdapter {
-    // Remote event_handler from the singleton Reactor.
-    bool operator()(EventHandler* handler)
-    {
-        Reactor::instance()->removeHandler(handler);
-        return true;
-    }
-};
+    : poller(epoll_create1(EPOLL_CLOEXEC))
+    , runningEventLoop(true)
+{
+    if (poller < 0)
+        throw std::runtime_error("Can't create the reactor's epoll instance");
+}
 
 Reactor::~Reactor()
 {
-    std::for_each(dispatchTable.begin(), dispatchTable.end(),
-        [this](Handler* handler) { removeHandler(handler); });
+    reap();
+    for (auto handler : dispatchTable)
+        delete handler;
+    close(poller);
+    inst = nullptr;
 }
 
 Reactor* Reactor::instance()
@@ -42,20 +38,157 @@ Reactor* Reactor::instance()
 
 void Reactor::registerHandler(Handler* handler)
 {
+    try {
+        watch(handler, EPOLLIN);
+    } catch (std::exception&) {
+        interest.erase(handler);
+        delete handler;
+        throw;
+    }
     dispatchTable.push_back(handler);
 }
 
 void Reactor::removeHandler(Handler* handler)
 {
-    auto iter = std::remove(dispatchTable.begin(), dispatchTable.end(), handler);
+    auto iter = std::find(dispatchTable.begin(), dispatchTable.end(), handler);
+    if (iter == dispatchTable.end())
+        return;
     dispatchTable.erase(iter);
-    delete handler;
+    watch(handler, 0);
+    interest.erase(handler);
+    cancelTimers(handler);
+    removed.push_back(handler);
+}
+
+void Reactor::suspendHandler(Handler* handler)
+{
+    watch(handler, interest[handler] & ~EPOLLIN);
+}
+
+void Reactor::resumeHandler(Handler* handler)
+{
+    watch(handler, interest[handler] | EPOLLIN);
+}
+
+void Reactor::watchOutput(Handler* handler, bool on)
+{
+    auto events = interest[handler];
+    watch(handler, on ? events | EPOLLOUT : events & ~EPOLLOUT);
+}
+
+void Reactor::scheduleTimer(Handler* handler, Clock::duration delay, Clock::duration interval)
+{
+    timers.emplace(Clock::now() + delay, Timer { handler, interval });
+}
+
+void Reactor::cancelTimers(Handler* handler)
+{
+    for (auto iter = timers.begin(); iter != timers.end();)
+        iter = iter->second.handler == handler ? timers.erase(iter) : std::next(iter);
+}
+
+void Reactor::watch(Handler* handler, std::uint32_t events)
+{
+    auto& current = interest[handler];
+    auto ready = std::find(alwaysReady.begin(), alwaysReady.end(), handler);
+    if (ready != alwaysReady.end()) {
+        // a regular file, which only ever has input to wait for
+        if (!(events & EPOLLIN))
+            alwaysReady.erase(ready);
+        current = events;
+        return;
+    }
+
+    epoll_event event {};
+    event.events = events;
+    event.data.ptr = handler;
+    int operation = current == 0 ? EPOLL_CTL_ADD : events == 0 ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
+    if ((current != 0 || events != 0)
+        && epoll_ctl(poller, operation, handler->descriptor(), &event) < 0) {
+        if (errno != EPERM || operation != EPOLL_CTL_ADD)
+            throw std::runtime_error("Can't wait for events on a handler's descriptor");
+        // a regular file: always readable, and epoll won't take it
+        alwaysReady.push_back(handler);
+    }
+    current = events;
+}
+
+void Reactor::dispatch(Handler* handler, std::uint32_t events)
+{
+    auto wants = [this, handler](std::uint32_t direction) {
+        auto iter = interest.find(handler);
+        return iter != interest.end() && (iter->second & direction);
+    };
+    // hangups and errors go to whichever side is waiting, which finds
+    // them when it reads or writes
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR) && wants(EPOLLIN))
+        handler->handle();
+    if (events & (EPOLLOUT | EPOLLHUP | EPOLLERR) && wants(EPOLLOUT))
+        handler->handleOutput();
+}
+
+void Reactor::reap()
+{
+    for (auto handler : removed)
+        delete handler;
+    removed.clear();
+}
+
+int Reactor::timeout() const
+{
+    if (timers.empty())
+        return -1;
+    auto wait = std::chrono::ceil<std::chrono::milliseconds>(timers.begin()->first - Clock::now());
+    return static_cast<int>(std::clamp<std::chrono::milliseconds::rep>(wait.count(), 0, INT_MAX));
+}
+
+void Reactor::expire()
+{
+    auto now = Clock::now();
+    std::vector<Handler*> due;
+    while (!timers.empty() && timers.begin()->first <= now) {
+        auto when = timers.begin()->first;
+        auto timer = timers.begin()->second;
+        timers.erase(timers.begin());
+        if (timer.interval > Clock::duration::zero()) {
+            // ticks missed while the loop was busy aren't made up
+            auto next = when + timer.interval;
+            timers.emplace(next > now ? next : now + timer.interval, timer);
+        }
+        due.push_back(timer.handler);
+    }
+
+    for (auto handler : due)
+        if (runningEventLoop && interest.count(handler))
+            handler->handleTimeout();
 }
 
 void Reactor::runEventLoop()
 {
-    while (runningEventLoop)
-        std::for_each(dispatchTable.begin(), dispatchTable.end(), std::mem_fn(&Handler::handle));
+    epoll_event events[maxEvents];
+
+    while (runningEventLoop && !dispatchTable.empty()) {
+        // don't sleep if some handler is always ready, and only until
+        // the next timer otherwise
+        int count = epoll_wait(poller, events, maxEvents, alwaysReady.empty() ? timeout() : 0);
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error("Can't wait for input");
+        }
+
+        for (int i = 0; i < count && runningEventLoop; ++i)
+            dispatch(static_cast<Handler*>(events[i].data.ptr), events[i].events);
+
+        // dispatching may add or remove handlers, so go over a copy
+        auto ready = alwaysReady;
+        for (auto handler : ready)
+            if (runningEventLoop)
+                dispatch(handler, EPOLLIN);
+
+        expire();
+        reap();
+    }
 }
 
 void Reactor::endEventLoop()
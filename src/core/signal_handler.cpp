@@ -0,0 +1,44 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "core/signal_handler.h"
+#include <csignal>
+#include <stdexcept>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+// Return the set of signals that end the event loop.
+static sigset_t terminating()
+{
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    return set;
+}
+
+SignalHandler::SignalHandler()
+{
+    auto set = terminating();
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+    signals = signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signals < 0) {
+        pthread_sigmask(SIG_UNBLOCK, &set, nullptr);
+        throw std::runtime_error("Can't create a signalfd");
+    }
+}
+
+SignalHandler::~SignalHandler()
+{
+    close(signals);
+}
+
+void SignalHandler::handle()
+{
+    signalfd_siginfo info;
+    if (read(signals, &info, sizeof(info)) == sizeof(info))
+        Reactor::instance()->endEventLoop();
+}
+
+int SignalHandler::descriptor() const
+{
+    return signals;
+}
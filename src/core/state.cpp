@@ -1,6 +1,9 @@
 /* Copyright G. Hemingway @ 2022, All Rights Reserved */
 #include "core/context.h"
+#include "core/options.h"
+#include "core/tracer.h"
 #include "interpreter/interpreter.h"
+#include "interpreter/pratt_parser.h"
 #include "tree/expression_tree_iterator.h"
 #include "visitors/evaluation.h"
 #include "visitors/print.h"
@@ -9,19 +12,58 @@
 #include <stdexcept>
 
 // this method traverses the tree in with a given traversal strategy
-void State::printTree(const ExpressionTree& tree, const std::string& order, std::ostream& os)
+void State::printTree(Context& context, const std::string& order, OutputSink& os)
 {
+    if (Options::instance()->variant()) {
+        context.variantTree().print(order, os);
+        return;
+    }
+
     // create a print visitor & traverse in order
+    Tracer::Span span("print visitor", "traversal");
+    const ExpressionTree& tree = context.tree();
     PrintVisitor visitor(os);
-    std::for_each(
-        tree.begin(order), tree.end(order), [&visitor](auto node) { node.accept(visitor); });
-}
+    std::int64_t nodes = 0;
+    std::for_each(tree.begin(order), tree.end(order), [&visitor, &nodes](auto node) {
+        node.accept(visitor);
+        ++nodes;
+    });
+    span.count("nodes", nodes);
+}
+
+// Post-order evaluation runs the tree's compiled Bytecode, or the
+// context's IncrementalEvaluator, ParallelEvaluator or VariantTree when
+// those are on.
+// Any other order, or a program that traps on division by zero, is
+// handled by walking the tree with an EvaluationVisitor, which also
+// reports the error.
+int State::evaluateTree(Context& context, const std::string& order)
+{
+    int result;
+    if (order == "post-order") {
+        Tracer::Span span("evaluate", "evaluate");
+        if (Options::instance()->incremental()) {
+            if (context.incremental().evaluate(context.getVariables(), result))
+                return result;
+        } else if (Options::instance()->threads() > 0) {
+            if (context.parallel().evaluate(context.getVariables(), result))
+                return result;
+        } else if (Options::instance()->variant()) {
+            if (context.variantTree().evaluate(context.getVariables(), result))
+                return result;
+        } else if (context.program().run(context.getVariables(), result))
+            return result;
+    }
 
-auto State::evaluateTree(const ExpressionTree& tree, const std::string& order)
-{
-    EvaluationVisitor visitor;
-    std::for_each(
-        tree.begin(order), tree.end(order), [&visitor](auto node) { node.accept(visitor); });
+    Tracer::Span span("evaluation visitor", "traversal");
+    const ExpressionTree& tree = context.tree();
+    EvaluationVisitor visitor(context.getVariables());
+    std::int64_t nodes = 0;
+    std::for_each(tree.begin(order), tree.end(order), [&visitor, &nodes](auto node) {
+        node.accept(visitor);
+        ++nodes;
+    });
+    span.count("nodes", nodes);
     return visitor.total();
 }
 
@@ -95,7 +137,7 @@ void UninitializedState::makeTree(const std::string&)
     throw State::InvalidState("Expr - Can't call that command yet.");
 }
 
-void UninitializedState::print(const std::string&, std::ostream&)
+void UninitializedState::print(const std::string&, OutputSink&)
 {
     throw State::InvalidState("Print - Can't call that command yet.");
 }
@@ -105,6 +147,11 @@ int UninitializedState::evaluate(const std::string&)
     throw State::InvalidState("Eval - Can't call that command yet.");
 }
 
+std::size_t UninitializedState::optimize()
+{
+    throw State::InvalidState("Optimize - Can't call that command yet.");
+}
+
 void UninitializedState::printValidCommands() const
 {
     auto& os = context.output();
@@ -134,14 +181,14 @@ void PreOrderUninitializedState::makeTree(const std::string&)
     throw State::InvalidState("Pre_Order_Uninitialized_State::make_tree - not implemented");
 }
 
-void PreOrderInitializedState::print(const std::string& format, std::ostream& os)
+void PreOrderInitializedState::print(const std::string& format, OutputSink& os)
 {
-    State::printTree(context.tree(), format, os);
+    State::printTree(context, format, os);
 }
 
 int PreOrderInitializedState::evaluate(const std::string& param)
 {
-    return State::evaluateTree(context.tree(), param);
+    return State::evaluateTree(context, param);
 }
 
 PostOrderUninitializedState::PostOrderUninitializedState(Context& ctx)
@@ -154,14 +201,14 @@ void PostOrderUninitializedState::makeTree(const std::string&)
     throw State::InvalidState("Post_Order_Uninitialized_State::make_tree - not implemented");
 }
 
-void PostOrderInitializedState::print(const std::string& format, std::ostream& os)
+void PostOrderInitializedState::print(const std::string& format, OutputSink& os)
 {
-    return State::printTree(context.tree(), format, os);
+    return State::printTree(context, format, os);
 }
 
 int PostOrderInitializedState::evaluate(const std::string& param)
 {
-    return State::evaluateTree(context.tree(), param);
+    return State::evaluateTree(context, param);
 }
 
 LevelOrderUninitializedState::LevelOrderUninitializedState(Context& ctx)
@@ -174,14 +221,14 @@ void LevelOrderUninitializedState::makeTree(const std::string&)
     throw State::InvalidState("LevelOrderUninitializedState::makeTree - not implemented");
 }
 
-void LevelOrderInitializedState::print(const std::string& format, std::ostream& os)
+void LevelOrderInitializedState::print(const std::string& format, OutputSink& os)
 {
-    State::printTree(context.tree(), format, os);
+    State::printTree(context, format, os);
 }
 
 int LevelOrderInitializedState::evaluate(const std::string& param)
 {
-    return State::evaluateTree(context.tree(), param);
+    return State::evaluateTree(context, param);
 }
 
 InOrderUninitializedState::InOrderUninitializedState(Context& ctx)
@@ -191,7 +238,39 @@ InOrderUninitializedState::InOrderUninitializedState(Context& ctx)
 
 void InOrderUninitializedState::makeTree(const std::string& expr)
 {
-    context.tree(Interpreter::interpret(context.getVariables(), expr));
+    auto& cache = context.expressions();
+    auto key = ExpressionCache::normalize(expr);
+
+    if (auto entry = cache.find(key)) {
+        // seen it before, so skip parsing and compiling
+        context.tree(entry->tree, entry->program, key);
+    } else {
+        ExpressionTree tree;
+        auto options = Options::instance();
+        std::size_t stored;
+        if (auto archive = context.archive(); archive && archive->find(key, stored))
+            // saved earlier, so build it without parsing
+            tree = archive->tree(stored, options->share());
+        else if (options->pratt())
+            tree = PrattParser::parse(context.getVariables(), expr, options->share());
+        else if (options->arena() || options->share())
+            tree = Interpreter::interpretFlat(context.getVariables(), expr, options->share());
+        else
+            tree = Interpreter::interpret(context.getVariables(), expr);
+
+        if (options->optimize()) {
+            std::size_t removed;
+            tree = tree.simplify(removed, options->share());
+        }
+
+        // it's compiled when it's first evaluated, since it may only be
+        // printed
+        if (cache.capacity() > 0) {
+            cache.insert(key, { tree, nullptr });
+            context.tree(tree, nullptr, key);
+        } else
+            context.tree(tree);
+    }
     context.state(new InOrderInitializedState(context));
 }
 
@@ -219,14 +298,21 @@ InOrderInitializedState::InOrderInitializedState(Context& ctx)
 {
 }
 
-void InOrderInitializedState::print(const std::string& format, std::ostream& os)
+void InOrderInitializedState::print(const std::string& format, OutputSink& os)
 {
-    State::printTree(context.tree(), format, os);
+    State::printTree(context, format, os);
 }
 
 int InOrderInitializedState::evaluate(const std::string& param)
 {
-    return State::evaluateTree(context.tree(), param);
+    return State::evaluateTree(context, param);
+}
+
+std::size_t InOrderInitializedState::optimize()
+{
+    std::size_t removed;
+    context.tree(context.tree().simplify(removed, Options::instance()->share()));
+    return removed;
 }
 
 void InOrderInitializedState::printValidCommands() const
@@ -234,6 +320,7 @@ void InOrderInitializedState::printValidCommands() const
     auto& os = context.output();
     os << "1a. eval [post-order]\n";
     os << "1b. print [in-order | pre-order | post-order | level-order]\n";
+    os << "1c. optimize\n";
     os << "0a. format [in-order]\n";
     os << "0b. set [variable=value]\n";
     if (!context.getVariables().isEmpty()) {
@@ -0,0 +1,128 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "core/tracer.h"
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <unistd.h>
+
+// Return a small number identifying the calling thread in the trace.
+static std::uint32_t threadNumber()
+{
+    static std::atomic<std::uint32_t> threads(0);
+    thread_local std::uint32_t number = ++threads;
+    return number;
+}
+
+Tracer::Span::Span(const char* name, const char* category)
+    : name(name)
+    , category(category)
+    , tracing(Tracer::instance()->enabled())
+    , what(nullptr)
+    , value(0)
+{
+    if (tracing)
+        start = std::chrono::steady_clock::now();
+}
+
+Tracer::Span::~Span()
+{
+    if (!tracing)
+        return;
+    auto tracer = Tracer::instance();
+    auto finish = std::chrono::steady_clock::now();
+    tracer->record({ name, category,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(start - tracer->epoch).count(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start).count(),
+        threadNumber(), what, value });
+}
+
+void Tracer::Span::count(const char* what, std::int64_t value)
+{
+    this->what = what;
+    this->value = value;
+}
+
+Tracer* Tracer::inst = nullptr;
+
+Tracer::Tracer()
+    : tracing(false)
+    , epoch(std::chrono::steady_clock::now())
+    , recorded(0)
+{
+}
+
+Tracer::~Tracer()
+{
+    inst = nullptr;
+}
+
+Tracer* Tracer::instance()
+{
+    if (Tracer::inst == nullptr)
+        Tracer::inst = new Tracer;
+    return Tracer::inst;
+}
+
+void Tracer::enable(std::size_t capacity)
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        events.assign(capacity, Event {});
+        recorded = 0;
+        epoch = std::chrono::steady_clock::now();
+    }
+    tracing.store(capacity > 0, std::memory_order_release);
+}
+
+bool Tracer::enabled() const
+{
+    return tracing.load(std::memory_order_acquire);
+}
+
+void Tracer::record(const Event& event)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    events[recorded++ % events.size()] = event;
+}
+
+// Each span is a complete ("X") event, which carries its own duration,
+// so one that lost its start to the ring buffer can't be left dangling.
+std::size_t Tracer::write(std::ostream& os) const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    std::size_t count = recorded < events.size() ? recorded : events.size();
+    std::size_t first = recorded < events.size() ? 0 : recorded % events.size();
+    auto pid = static_cast<long>(getpid());
+
+    os << "{\"traceEvents\":[";
+    char line[256];
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto& event = events[(first + i) % events.size()];
+        // timestamps are in microseconds
+        int length = std::snprintf(line, sizeof(line),
+            "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+            "\"pid\":%ld,\"tid\":%" PRIu32,
+            i == 0 ? "" : ",", event.name, event.category, event.start / 1e3,
+            event.duration / 1e3, pid, event.thread);
+        os.write(line, length);
+        if (event.what) {
+            length = std::snprintf(
+                line, sizeof(line), ",\"args\":{\"%s\":%" PRId64 "}", event.what, event.value);
+            os.write(line, length);
+        }
+        os << '}';
+    }
+    os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    return count;
+}
+
+std::size_t Tracer::write(const std::string& path) const
+{
+    std::ofstream file(path);
+    auto count = write(file);
+    file.close();
+    if (!file)
+        throw std::runtime_error("Can't write " + path);
+    return count;
+}
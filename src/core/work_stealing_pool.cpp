@@ -0,0 +1,156 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "core/work_stealing_pool.h"
+
+// The pool the calling thread works for, and the index of its queue.
+static thread_local const WorkStealingPool* currentPool = nullptr;
+static thread_local std::size_t currentQueue = 0;
+
+// Ctor
+WorkStealingPool::Task::Task(std::function<void()> work)
+    : work(std::move(work))
+    , finished(false)
+{
+}
+
+// run the work, keeping any exception for join() to rethrow
+void WorkStealingPool::Task::run()
+{
+    try {
+        work();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    finished.store(true, std::memory_order_release);
+}
+
+WorkStealingPool* WorkStealingPool::inst = nullptr;
+
+WorkStealingPool* WorkStealingPool::instance()
+{
+    return inst;
+}
+
+void WorkStealingPool::instance(WorkStealingPool* pool)
+{
+    inst = pool;
+}
+
+// Ctor
+WorkStealingPool::WorkStealingPool(std::size_t threads)
+    : queued(0)
+    , stopping(false)
+{
+    for (std::size_t i = 0; i <= threads; ++i)
+        queues.push_back(std::make_unique<Queue>());
+    for (std::size_t i = 0; i < threads; ++i)
+        workers.emplace_back(&WorkStealingPool::work, this, i);
+}
+
+// Dtor
+WorkStealingPool::~WorkStealingPool()
+{
+    if (inst == this)
+        inst = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(idleLock);
+        stopping = true;
+    }
+    idle.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+}
+
+// return the number of workers
+std::size_t WorkStealingPool::size() const
+{
+    return workers.size();
+}
+
+// return the queue owned by the calling thread
+std::size_t WorkStealingPool::self() const
+{
+    return currentPool == this ? currentQueue : workers.size();
+}
+
+// queue a task on the caller's own queue and wake an idle worker
+void WorkStealingPool::fork(Task& task)
+{
+    auto& queue = *queues[self()];
+    {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.tasks.push_back(&task);
+    }
+    {
+        // taking the lock orders this with a worker about to sleep
+        std::lock_guard<std::mutex> guard(idleLock);
+        ++queued;
+    }
+    idle.notify_one();
+}
+
+// help out until the task is done
+void WorkStealingPool::join(Task& task)
+{
+    auto queue = self();
+    while (!task.finished.load(std::memory_order_acquire)) {
+        if (auto other = find(queue))
+            other->run();
+        else
+            // the task is running on another thread
+            std::this_thread::yield();
+    }
+    if (task.error)
+        std::rethrow_exception(task.error);
+}
+
+// take a task from one end of a queue
+WorkStealingPool::Task* WorkStealingPool::take(std::size_t index, bool own)
+{
+    auto& queue = *queues[index];
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.tasks.empty())
+        return nullptr;
+
+    Task* task;
+    if (own) {
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+    } else {
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+    }
+    --queued;
+    return task;
+}
+
+// look in our own queue, then steal from the others starting with our
+// neighbour so thieves spread out
+WorkStealingPool::Task* WorkStealingPool::find(std::size_t self)
+{
+    if (queued.load() == 0)
+        return nullptr;
+    if (auto task = take(self, true))
+        return task;
+    for (std::size_t i = 1; i < queues.size(); ++i)
+        if (auto task = take((self + i) % queues.size(), false))
+            return task;
+    return nullptr;
+}
+
+// run tasks until the pool shuts down, sleeping while there are none
+void WorkStealingPool::work(std::size_t self)
+{
+    currentPool = this;
+    currentQueue = self;
+
+    while (true) {
+        if (auto task = find(self)) {
+            task->run();
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(idleLock);
+        idle.wait(guard, [this]() { return stopping || queued > 0; });
+        if (stopping)
+            return;
+    }
+}
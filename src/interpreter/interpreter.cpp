@@ -1,8 +1,10 @@
 /* Copyright G. Hemingway @ 2022, All Rights Reserved */
 #include "interpreter/interpreter.h"
+#include "core/tracer.h"
 #include "interpreter/symbol.h"
 #include "interpreter/variable_map.h"
 #include <memory>
+#include <vector>
 
 // method for checking if a character is a valid operator
 [[maybe_unused]] bool Interpreter::isOperator(char input)
@@ -11,20 +13,6 @@
         || input == '%' || input == '!' || input == '|' || input == '_';
 }
 
-// method for checking if a character is a number
-bool Interpreter::isNumber(char input)
-{
-    return input >= '0' && input <= '9';
-}
-
-// method for checking if a character is a candidate
-// for a part of a variable name
-bool Interpreter::isAlphanumeric(char input)
-{
-    return (input >= 'a' && input <= 'z') || (input >= 'A' && input <= 'Z')
-        || (input >= '0' && input <= '9');
-}
-
 // inserts a terminal into the parse tree
 [[maybe_unused]] void Interpreter::terminalInsert(Symbol* terminal, std::list<Symbol*>& list)
 {
@@ -48,68 +36,73 @@ bool Interpreter::isAlphanumeric(char input)
 }
 
 // inserts a variable (leaf node / number) into the parse tree
-void Interpreter::variableInsert(const VariableMap& vars, const std::string& input,
-    std::string::size_type& i, int& accumulatedPrecedence, std::list<Symbol*>& list,
-    Symbol*& lastValidInput)
+void Interpreter::variableInsert(VariableMap& vars, const Lexer::Token& token,
+    int& accumulatedPrecedence, std::list<Symbol*>& list, Symbol*& lastValidInput)
 {
-    // merge all consecutive number chars into a single
-    // Number symbol, eg '123' = int (123). Scope of j needs
-    // to be outside of the for loop.
-
-    std::string::size_type j = 1;
-
-    for (; i + j <= input.length() && isAlphanumeric(input[i + j]); ++j)
-        continue;
+    // intern the variable in the context; its value is looked up
+    // each time the tree is evaluated
 
-    // lookup the variable in the context
+    int slot = vars.slot(token.text);
 
-    int value = vars.get(input.substr(i, j));
+    // make a Variable out of the slot
 
-    // make a Number out of the integer
+    auto variable = new Variable(token.text, slot);
+    variable->addPrecedence(accumulatedPrecedence);
 
-    auto number = new Number(value);
-    number->addPrecedence(accumulatedPrecedence);
-
-    lastValidInput = number;
+    lastValidInput = variable;
 
-    // update i to the last character that was a number. the ++i will
-    // update the i at the end of the loop to the next check.
-
-    i += j - 1;
-
-    precedenceInsert(number, list);
+    precedenceInsert(variable, list);
 }
 
 // inserts a leaf node / number into the parse tree
-void Interpreter::numberInsert(const std::string& input, std::string::size_type& i,
-    int& accumulatedPrecedence, std::list<Symbol*>& list, Symbol*& lastValidInput)
+void Interpreter::numberInsert(const Lexer::Token& token, int& accumulatedPrecedence,
+    std::list<Symbol*>& list, Symbol*& lastValidInput)
 {
-    // merge all consecutive number chars into a single Number symbol,
-    // eg '123' = int (123). Scope of j needs to be outside of the for
-    // loop.
-
-    std::string::size_type j = 1;
-
-    for (; i + j <= input.length() && isNumber(input[i + j]); ++j)
-        continue;
+    // the lexer has already merged all consecutive number chars into a
+    // single token, eg '123' = int (123)
 
-    auto number = new Number(input.substr(i, j));
+    auto number = new Number(token.value);
     number->addPrecedence(accumulatedPrecedence);
 
     lastValidInput = number;
 
-    // update i to the last character that was a number. the ++i will
-    // update the i at the end of the loop to the next check.
-
-    i += j - 1;
-
     precedenceInsert(number, list);
 }
 
 // inserts a multiplication or division into the parse tree
 void Interpreter::precedenceInsert(Symbol* op, std::list<Symbol*>& list)
 {
-    if (!list.empty()) {
+    if (!list.empty() && dynamic_cast<UnaryOperator*>(op)) {
+        // a prefix operator starts the next operand, so it takes the
+        // empty slot at the bottom of the right spine.  Walking down by
+        // precedence instead would stop above an exponent or another
+        // negation waiting for its operand, and drop it.
+        Symbol* parent = list.back();
+        for (; parent->right; parent = parent->right)
+            continue;
+        parent->right = op;
+    } else if (!list.empty() && !op->left
+        && (dynamic_cast<Operator*>(op) || dynamic_cast<LeftUnaryOperator*>(op))) {
+        // a binary or postfix operator takes as its left operand the
+        // subtree at the bottom of the right spine whose operators all
+        // bind at least as tightly as it does.  This is found from the
+        // bottom up, since a negation on the spine binds less tightly
+        // than an exponent above it, e.g. in 2^-3^2.
+        std::vector<Symbol*> spine { list.back() };
+        while (spine.back()->right)
+            spine.push_back(spine.back()->right);
+
+        auto left = spine.size() - 1;
+        while (left > 0 && spine[left - 1]->precedence() >= op->precedence())
+            --left;
+
+        op->left = spine[left];
+        if (left == 0) {
+            list.pop_back();
+            list.push_back(op);
+        } else
+            spine[left - 1]->right = op;
+    } else if (!list.empty()) {
         // if last element was a number, then make that our left_
 
         Symbol* parent = list.back();
@@ -124,10 +117,8 @@ void Interpreter::precedenceInsert(Symbol* op, std::list<Symbol*>& list)
         if (parent->precedence() < op->precedence()) {
 
             // op left will be the old child. new parent child will be
-            // the op. To allow infinite negations, we have to check for
-            // unary_operator.
-
-            // **************** This is the culprit
+            // the op.  Operands and parenthesized groups have no old
+            // child, since they fill the empty slot at the bottom.
 
             if (!op->left)
                 op->left = child;
@@ -136,46 +127,33 @@ void Interpreter::precedenceInsert(Symbol* op, std::list<Symbol*>& list)
         } else {
             // this can be one of two things, either we are the same
             // precedence or we are less precedence than the parent.
-            // this also means different things for unary ops. The
-            // most recent unary op (negate) has a higher precedence
-
-            if (dynamic_cast<UnaryOperator*>(op)) {
-                for (; child && child->precedence() == op->precedence(); child = child->right)
-                    parent = child;
-
-                // I can't think of a valid reason that parent->right would
-                // be possible !0
-
-                parent->right = op;
-            } else {
-                // everything else is evaluated the same. For instance, if
-                // this is 5 * 4 / 2, and we currently have Mult (5,4) in the
-                // list, we need to make parent our left child.
-
-                op->left = parent;
-                list.pop_back();
-                list.push_back(op);
-            }
+            // Either way, if this is 5 * 4 / 2, and we currently have
+            // Mult (5,4) in the list, we need to make parent our left
+            // child.
+
+            op->left = parent;
+            list.pop_back();
+            list.push_back(op);
         }
     } else {
         list.push_back(op);
     }
 }
 
-void Interpreter::mainLoop(const VariableMap& vars, const std::string& input,
-    std::string::size_type& i, Symbol*& lastValidInput, bool& handled, int& accumulatedPrecedence,
-    std::list<Symbol*>& list)
+void Interpreter::mainLoop(VariableMap& vars, const Lexer::Token& token, Lexer& lexer,
+    Symbol*& lastValidInput, bool& handled, int& accumulatedPrecedence, std::list<Symbol*>& list)
 {
     handled = false;
-    if (isNumber(input[i])) {
+    char c = token.text.empty() ? '\0' : token.text[0];
+    if (token.kind == Lexer::Token::Kind::Number) {
         handled = true;
         // leaf node
-        numberInsert(input, i, accumulatedPrecedence, list, lastValidInput);
-    } else if (isAlphanumeric(input[i])) {
+        numberInsert(token, accumulatedPrecedence, list, lastValidInput);
+    } else if (token.kind == Lexer::Token::Kind::Identifier) {
         handled = true;
         // variable leaf node
-        variableInsert(vars, input, i, accumulatedPrecedence, list, lastValidInput);
-    } else if (input[i] == '+') {
+        variableInsert(vars, token, accumulatedPrecedence, list, lastValidInput);
+    } else if (c == '+') {
         handled = true;
         // addition operation
         auto op = new Add();
@@ -185,7 +163,7 @@ void Interpreter::mainLoop(const VariableMap& vars, const std::string& input,
 
         // insert the op according to left-to-right relationships
         precedenceInsert(op, list);
-    } else if (input[i] == '-') {
+    } else if (c == '-') {
         handled = true;
 
         Symbol* op;
@@ -204,7 +182,7 @@ void Interpreter::mainLoop(const VariableMap& vars, const std::string& input,
         // insert the op according to left-to-right relationships
         precedenceInsert(op, list);
 
-    } else if (input[i] == '*') {
+    } else if (c == '*') {
         handled = true;
         // multiplication operation
         auto op = new Multiply();
@@ -215,7 +193,7 @@ void Interpreter::mainLoop(const VariableMap& vars, const std::string& input,
         // insert the op according to precedence relationships
         precedenceInsert(op, list);
         // associative_insert (op);
-    } else if (input[i] == '/') {
+    } else if (c == '/') {
         handled = true;
         // division operation
         auto op = new Divide();
@@ -226,7 +204,7 @@ void Interpreter::mainLoop(const VariableMap& vars, const std::string& input,
         // insert the op according to precedence relationships
         precedenceInsert(op, list);
 
-    } else if (input[i] == '|') {
+    } else if (c == '|') {
         handled = true;
         // modulus operation
         auto op = new Ceiling();
@@ -237,7 +215,7 @@ void Interpreter::mainLoop(const VariableMap& vars, const std::string& input,
         // insert the op according to precedence relationships
         precedenceInsert(op, list);
 
-    } else if (input[i] == '_') {
+    } else if (c == '_') {
         handled = true;
         // modulus operation
         auto op = new Floor();
@@ -248,7 +226,7 @@ void Interpreter::mainLoop(const VariableMap& vars, const std::string& input,
         // insert the op according to precedence relationships
         precedenceInsert(op, list);
 
-    } else if (input[i] == '%') {
+    } else if (c == '%') {
         handled = true;
         // modulus operation
         auto op = new Modulus();
@@ -258,7 +236,7 @@ void Interpreter::mainLoop(const VariableMap& vars, const std::string& input,
 
         // insert the op according to precedence relationships
         precedenceInsert(op, list);
-    } else if (input[i] == '^') {
+    } else if (c == '^') {
         handled = true;
         // exponent operation
         auto op = new Exponent();
@@ -269,7 +247,7 @@ void Interpreter::mainLoop(const VariableMap& vars, const std::string& input,
         // insert the op according to precedence relationships
         precedenceInsert(op, list);
 
-    } else if (input[i] == '!') {
+    } else if (c == '!') {
         handled = true;
         // factorial operation
         auto op = new Factorial();
@@ -278,18 +256,15 @@ void Interpreter::mainLoop(const VariableMap& vars, const std::string& input,
         // insert the op according to precedence relationships
         precedenceInsert(op, list);
 
-    } else if (input[i] == '(') {
-        handled = true;
-        handleParenthesis(vars, input, i, lastValidInput, handled, accumulatedPrecedence, list);
-    } else if (input[i] == ' ' || input[i] == '\n') {
+    } else if (c == '(') {
         handled = true;
-        // skip whitespace
+        handleParenthesis(vars, lexer, lastValidInput, handled, accumulatedPrecedence, list);
     }
+    // whitespace never gets here; the lexer skips it
 }
 
-void Interpreter::handleParenthesis(const VariableMap& vars, const std::string& input,
-    std::string::size_type& i, Symbol*& lastValidInput, bool& handled, int& accumulatedPrecedence,
-    std::list<Symbol*>& master_list)
+void Interpreter::handleParenthesis(VariableMap& vars, Lexer& lexer, Symbol*& lastValidInput,
+    bool& handled, int& accumulatedPrecedence, std::list<Symbol*>& master_list)
 {
     /* handle parenthesis is a lot like handling a new interpret.
        the difference is that we have to worry about how the calling
@@ -299,9 +274,11 @@ void Interpreter::handleParenthesis(const VariableMap& vars, const std::string&
     accumulatedPrecedence += 5;
     std::list<Symbol*> list;
     handled = false;
-    for (++i; i < input.length(); ++i) {
-        mainLoop(vars, input, i, lastValidInput, handled, accumulatedPrecedence, list);
-        if (input[i] == ')') {
+    for (auto token = lexer.next(); token.kind != Lexer::Token::Kind::End; token = lexer.next()) {
+        mainLoop(vars, token, lexer, lastValidInput, handled, accumulatedPrecedence, list);
+        // a nested group consumes its own ')', so this one only closes
+        // this group
+        if (token.kind == Lexer::Token::Kind::Operator && token.text[0] == ')') {
             // std::cerr << "Handling a closing parenthesis.\n";
             handled = true;
             //++i;
@@ -332,31 +309,62 @@ void Interpreter::handleParenthesis(const VariableMap& vars, const std::string&
     list.clear();
 }
 
-// Converts a string and context into a parse tree and builds an
-// expression tree out of the parse tree.
+// Converts a string and context into a parse tree.
 
-ExpressionTree Interpreter::interpret(const VariableMap& vars, const std::string& input)
+void Interpreter::parse(VariableMap& vars, std::string_view input, std::list<Symbol*>& list)
 {
-    std::list<Symbol*> list;
-    // list.clear ();
+    Tracer::Span span("parse", "parse");
+    span.count("characters", static_cast<std::int64_t>(input.size()));
     Symbol* lastValidInput = nullptr;
     bool handled = false;
     int accumulatedPrecedence = 0;
 
-    for (std::string::size_type i = 0; i < input.length(); ++i) {
-        mainLoop(vars, input, i, lastValidInput, handled, accumulatedPrecedence, list);
+    Lexer lexer(input);
+    for (auto token = lexer.next(); token.kind != Lexer::Token::Kind::End; token = lexer.next()) {
+        mainLoop(vars, token, lexer, lastValidInput, handled, accumulatedPrecedence, list);
     }
+}
+
+// Converts a string and context into a parse tree and builds an
+// expression tree out of the parse tree.
+
+ExpressionTree Interpreter::interpret(VariableMap& vars, std::string_view input)
+{
+    std::list<Symbol*> list;
+    parse(vars, input, list);
 
     // if the list has an element in it, then return the back of the list.
     if (!list.empty()) {
         // Invoke a recursive ExpressionTree build starting with the
         // root symbol. This is an example of the builder pattern. See
         // pg 97 in GoF book.
-        ExpressionTree tree = ExpressionTree(list.back()->build());
-        delete list.back();
-        return tree;
+        std::unique_ptr<Symbol> root(list.back());
+        Tracer::Span span("build", "build");
+        return ExpressionTree(root->build());
     }
 
     // If we reach this, we didn't have any symbols.
     return {};
 }
+
+// Converts a string and context into a parse tree and builds a
+// FlatTree-backed expression tree out of the parse tree.
+
+ExpressionTree Interpreter::interpretFlat(VariableMap& vars, std::string_view input, bool share)
+{
+    std::list<Symbol*> list;
+    parse(vars, input, list);
+
+    if (!list.empty()) {
+        // Same recursive build as interpret(), except every node is
+        // appended to one arena instead of being allocated separately.
+        std::unique_ptr<Symbol> root(list.back());
+        Tracer::Span span("build", "build");
+        auto tree = std::make_unique<FlatTree>(share);
+        root->build(*tree);
+        span.count("nodes", static_cast<std::int64_t>(tree->size()));
+        return ExpressionTree(tree.release());
+    }
+
+    return {};
+}
@@ -0,0 +1,63 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "interpreter/lexer.h"
+#include <charconv>
+#include <stdexcept>
+
+// Ctor
+Lexer::Lexer(std::string_view input)
+    : input(input)
+    , position(0)
+{
+}
+
+// method for checking if a character is a number
+bool Lexer::isNumber(char input)
+{
+    return input >= '0' && input <= '9';
+}
+
+// method for checking if a character is a candidate
+// for a part of a variable name
+bool Lexer::isAlphanumeric(char input)
+{
+    return (input >= 'a' && input <= 'z') || (input >= 'A' && input <= 'Z')
+        || (input >= '0' && input <= '9');
+}
+
+// return the next token
+Lexer::Token Lexer::next()
+{
+    // skip whitespace
+    while (position < input.length()
+        && (input[position] == ' ' || input[position] == '\t' || input[position] == '\n'
+            || input[position] == '\r'))
+        ++position;
+
+    if (position == input.length())
+        return { Token::Kind::End, input.substr(position), 0 };
+
+    auto start = position;
+    char c = input[position++];
+
+    if (isNumber(c)) {
+        // merge all consecutive number chars into a single token,
+        // eg '123' = int (123)
+        for (; position < input.length() && isNumber(input[position]); ++position)
+            continue;
+
+        int value = 0;
+        auto result = std::from_chars(input.data() + start, input.data() + position, value);
+        if (result.ec != std::errc())
+            throw std::invalid_argument("Number is out of range");
+        return { Token::Kind::Number, input.substr(start, position - start), value };
+    }
+
+    if (isAlphanumeric(c)) {
+        // merge all consecutive alphanumeric chars into a single token
+        for (; position < input.length() && isAlphanumeric(input[position]); ++position)
+            continue;
+        return { Token::Kind::Identifier, input.substr(start, position - start), 0 };
+    }
+
+    return { Token::Kind::Operator, input.substr(start, 1), 0 };
+}
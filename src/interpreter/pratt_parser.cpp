@@ -0,0 +1,158 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "interpreter/pratt_parser.h"
+#include "core/tracer.h"
+#include "interpreter/lexer.h"
+#include "interpreter/variable_map.h"
+#include <memory>
+#include <stdexcept>
+
+// Precedence levels, matching the ones used by the Symbol classes.
+static constexpr int additivePrecedence = 1;
+static constexpr int multiplicativePrecedence = 2;
+static constexpr int negatePrecedence = 3;
+static constexpr int exponentPrecedence = 4;
+
+// Marker used on the operator stack for an open parenthesis.  It has
+// the lowest precedence so no operator reduces past it.
+static constexpr int parenthesisPrecedence = 0;
+
+// look up a binary operator
+bool PrattParser::binaryOperator(char input, FlatTree::Opcode& opcode, int& precedence)
+{
+    switch (input) {
+    case '+':
+        opcode = FlatTree::Opcode::Add;
+        precedence = additivePrecedence;
+        return true;
+    case '-':
+        opcode = FlatTree::Opcode::Subtract;
+        precedence = additivePrecedence;
+        return true;
+    case '*':
+        opcode = FlatTree::Opcode::Multiply;
+        precedence = multiplicativePrecedence;
+        return true;
+    case '/':
+        opcode = FlatTree::Opcode::Divide;
+        precedence = multiplicativePrecedence;
+        return true;
+    case '%':
+        opcode = FlatTree::Opcode::Modulus;
+        precedence = multiplicativePrecedence;
+        return true;
+    case '|':
+        opcode = FlatTree::Opcode::Ceiling;
+        precedence = multiplicativePrecedence;
+        return true;
+    case '_':
+        opcode = FlatTree::Opcode::Floor;
+        precedence = multiplicativePrecedence;
+        return true;
+    case '^':
+        opcode = FlatTree::Opcode::Exponent;
+        precedence = exponentPrecedence;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// build the node for the operator on top of the stack
+void PrattParser::reduce(FlatTree& tree, std::vector<PendingOperator>& operators,
+    std::vector<FlatTree::Index>& operands)
+{
+    auto op = operators.back();
+    operators.pop_back();
+
+    if (op.opcode == FlatTree::Opcode::Negate) {
+        if (operands.empty())
+            throw std::invalid_argument("Required operands not given");
+        operands.back() = tree.makeUnary(op.opcode, operands.back());
+    } else {
+        if (operands.size() < 2)
+            throw std::invalid_argument("Required operands not given");
+        auto right = operands.back();
+        operands.pop_back();
+        operands.back() = tree.makeBinary(op.opcode, operands.back(), right);
+    }
+}
+
+// Converts a string and variables into an expression tree.  All binary
+// operators are left associative, negation binds tighter than the
+// multiplicative operators but looser than exponentiation, and the
+// postfix factorial binds tightest of all.
+ExpressionTree PrattParser::parse(VariableMap& vars, std::string_view input, bool share)
+{
+    // parsing builds the tree as it goes, so there's no separate build
+    Tracer::Span span("parse", "parse");
+    auto tree = std::make_unique<FlatTree>(share);
+    std::vector<PendingOperator> operators;
+    std::vector<FlatTree::Index> operands;
+
+    // true when the next token must start an operand, which is also what
+    // distinguishes a negation from a subtraction
+    bool expectOperand = true;
+
+    Lexer lexer(input);
+    for (auto token = lexer.next(); token.kind != Lexer::Token::Kind::End; token = lexer.next()) {
+        char c = token.text[0];
+        FlatTree::Opcode opcode;
+        int precedence;
+
+        if (token.kind != Lexer::Token::Kind::Operator) {
+            if (!expectOperand)
+                throw std::invalid_argument("Missing operator before operand");
+
+            if (token.kind == Lexer::Token::Kind::Number)
+                operands.push_back(tree->makeLeaf(token.value));
+            else
+                operands.push_back(tree->makeVariable(token.text, vars.slot(token.text)));
+
+            expectOperand = false;
+        } else if (c == '(') {
+            if (!expectOperand)
+                throw std::invalid_argument("Missing operator before parenthesis");
+            operators.push_back({ FlatTree::Opcode::Number, parenthesisPrecedence });
+        } else if (c == ')') {
+            // reduce everything back to the matching open parenthesis
+            while (!operators.empty() && operators.back().precedence != parenthesisPrecedence)
+                reduce(*tree, operators, operands);
+            if (operators.empty())
+                throw std::invalid_argument("Unmatched closing parenthesis");
+            operators.pop_back();
+        } else if (c == '-' && expectOperand) {
+            // prefix operators can't reduce anything yet
+            operators.push_back({ FlatTree::Opcode::Negate, negatePrecedence });
+        } else if (c == '!') {
+            // nothing binds tighter than factorial, so apply it right away
+            if (expectOperand)
+                throw std::invalid_argument("Required operands not given");
+            operands.back() = tree->makeUnary(FlatTree::Opcode::Factorial, operands.back());
+        } else if (binaryOperator(c, opcode, precedence)) {
+            if (expectOperand)
+                throw std::invalid_argument("Required operands not given");
+            // left associativity: reduce pending operators that bind at
+            // least as tightly as this one
+            while (!operators.empty() && operators.back().precedence >= precedence)
+                reduce(*tree, operators, operands);
+            operators.push_back({ opcode, precedence });
+            expectOperand = true;
+        }
+        // anything else is skipped
+    }
+
+    // reduce whatever is left, treating unclosed parentheses as closed
+    while (!operators.empty()) {
+        if (operators.back().precedence == parenthesisPrecedence)
+            operators.pop_back();
+        else
+            reduce(*tree, operators, operands);
+    }
+
+    // If we reach this with no operands, we didn't have any symbols.
+    if (operands.empty())
+        return {};
+
+    span.count("nodes", static_cast<std::int64_t>(tree->size()));
+    return ExpressionTree(tree.release());
+}
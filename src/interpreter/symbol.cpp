@@ -11,6 +11,7 @@
 #include "tree/multiply_node.h"
 #include "tree/negate_node.h"
 #include "tree/subtract_node.h"
+#include "tree/variable_node.h"
 #include <cstdlib>
 #include <memory>
 
@@ -46,13 +47,6 @@ LeftUnaryOperator::LeftUnaryOperator(Symbol* left, int precedence)
     : Symbol(left, nullptr, precedence)
 {
 }
-// constructor
-Number::Number(const std::string& input)
-    : Symbol(nullptr, nullptr, 6)
-{
-    item = ::atoi(input.c_str());
-}
-
 // constructor
 Number::Number(const int& input)
     : Symbol(nullptr, nullptr, 6)
@@ -72,6 +66,38 @@ ComponentNode* Number::build()
     return new LeafNode(item);
 }
 
+// builds an equivalent node in the FlatTree
+FlatTree::Index Number::build(FlatTree& tree)
+{
+    return tree.makeLeaf(item);
+}
+
+// constructor
+Variable::Variable(std::string_view name, int slot)
+    : Symbol(nullptr, nullptr, 6)
+    , name(name)
+    , slot(slot)
+{
+}
+
+// returns the precedence level
+int Variable::addPrecedence(int accumulatedPrecedence)
+{
+    return this->prec = 6 + accumulatedPrecedence;
+}
+
+// builds an equivalent Expression_Tree node
+ComponentNode* Variable::build()
+{
+    return new VariableNode(std::string(name), slot);
+}
+
+// builds an equivalent node in the FlatTree
+FlatTree::Index Variable::build(FlatTree& tree)
+{
+    return tree.makeVariable(name, slot);
+}
+
 // constructor
 Negate::Negate()
     : UnaryOperator(nullptr, 3)
@@ -93,6 +119,15 @@ ComponentNode* Negate::build()
     return new NegateNode(right->build());
 }
 
+// builds an equivalent node in the FlatTree
+FlatTree::Index Negate::build(FlatTree& tree)
+{
+    if (right == nullptr) {
+        throw(std::invalid_argument("Required operands not given"));
+    }
+    return tree.makeUnary(FlatTree::Opcode::Negate, right->build(tree));
+}
+
 // constructor
 Add::Add()
     : Operator(nullptr, nullptr, 1)
@@ -114,6 +149,17 @@ ComponentNode* Add::build()
     return new AddNode(left->build(), right->build());
 }
 
+// builds an equivalent node in the FlatTree
+FlatTree::Index Add::build(FlatTree& tree)
+{
+    if (left == nullptr || right == nullptr) {
+        throw(std::invalid_argument("Required operands not given"));
+    }
+    auto lhs = left->build(tree);
+    auto rhs = right->build(tree);
+    return tree.makeBinary(FlatTree::Opcode::Add, lhs, rhs);
+}
+
 // constructor
 Subtract::Subtract()
     : Operator(nullptr, nullptr, 1)
@@ -135,6 +181,17 @@ ComponentNode* Subtract::build()
     return new SubtractNode(left->build(), right->build());
 }
 
+// builds an equivalent node in the FlatTree
+FlatTree::Index Subtract::build(FlatTree& tree)
+{
+    if (left == nullptr || right == nullptr) {
+        throw(std::invalid_argument("Required operands not given"));
+    }
+    auto lhs = left->build(tree);
+    auto rhs = right->build(tree);
+    return tree.makeBinary(FlatTree::Opcode::Subtract, lhs, rhs);
+}
+
 // constructor
 Multiply::Multiply()
     : Operator(nullptr, nullptr, 2)
@@ -156,6 +213,17 @@ ComponentNode* Multiply::build()
     return new MultiplyNode(left->build(), right->build());
 }
 
+// builds an equivalent node in the FlatTree
+FlatTree::Index Multiply::build(FlatTree& tree)
+{
+    if (left == nullptr || right == nullptr) {
+        throw(std::invalid_argument("Required operands not given"));
+    }
+    auto lhs = left->build(tree);
+    auto rhs = right->build(tree);
+    return tree.makeBinary(FlatTree::Opcode::Multiply, lhs, rhs);
+}
+
 // constructor
 Divide::Divide()
     : Operator(nullptr, nullptr, 2)
@@ -177,6 +245,17 @@ ComponentNode* Divide::build()
     return new DivideNode(left->build(), right->build());
 }
 
+// builds an equivalent node in the FlatTree
+FlatTree::Index Divide::build(FlatTree& tree)
+{
+    if (left == nullptr || right == nullptr) {
+        throw(std::invalid_argument("Required operands not given"));
+    }
+    auto lhs = left->build(tree);
+    auto rhs = right->build(tree);
+    return tree.makeBinary(FlatTree::Opcode::Divide, lhs, rhs);
+}
+
 // constructor
 Exponent::Exponent()
     : Operator(nullptr, nullptr, 4)
@@ -198,6 +277,17 @@ ComponentNode* Exponent::build()
     return new ExponentNode(left->build(), right->build());
 }
 
+// builds an equivalent node in the FlatTree
+FlatTree::Index Exponent::build(FlatTree& tree)
+{
+    if (left == nullptr || right == nullptr) {
+        throw(std::invalid_argument("Required operands not given"));
+    }
+    auto lhs = left->build(tree);
+    auto rhs = right->build(tree);
+    return tree.makeBinary(FlatTree::Opcode::Exponent, lhs, rhs);
+}
+
 // constructor
 Modulus::Modulus()
     : Operator(nullptr, nullptr, 2)
@@ -219,6 +309,17 @@ ComponentNode* Modulus::build()
     return new ModulusNode(left->build(), right->build());
 }
 
+// builds an equivalent node in the FlatTree
+FlatTree::Index Modulus::build(FlatTree& tree)
+{
+    if (left == nullptr || right == nullptr) {
+        throw(std::invalid_argument("Required operands not given"));
+    }
+    auto lhs = left->build(tree);
+    auto rhs = right->build(tree);
+    return tree.makeBinary(FlatTree::Opcode::Modulus, lhs, rhs);
+}
+
 // constructor
 Factorial::Factorial()
     : LeftUnaryOperator(nullptr, 5)
@@ -240,6 +341,15 @@ ComponentNode* Factorial::build()
     return new FactorialNode(left->build());
 }
 
+// builds an equivalent node in the FlatTree
+FlatTree::Index Factorial::build(FlatTree& tree)
+{
+    if (left == nullptr) {
+        throw(std::invalid_argument("Required operands not given"));
+    }
+    return tree.makeUnary(FlatTree::Opcode::Factorial, left->build(tree));
+}
+
 Ceiling::Ceiling()
     : Operator(nullptr, nullptr, 2)
 {
@@ -260,6 +370,17 @@ ComponentNode* Ceiling::build()
     return new CeilingNode(left->build(), right->build());
 }
 
+// builds an equivalent node in the FlatTree
+FlatTree::Index Ceiling::build(FlatTree& tree)
+{
+    if (left == nullptr || right == nullptr) {
+        throw(std::invalid_argument("Required operands not given"));
+    }
+    auto lhs = left->build(tree);
+    auto rhs = right->build(tree);
+    return tree.makeBinary(FlatTree::Opcode::Ceiling, lhs, rhs);
+}
+
 Floor::Floor()
     : Operator(nullptr, nullptr, 2)
 {
@@ -278,4 +399,15 @@ ComponentNode* Floor::build()
         throw(std::invalid_argument("Required operands not given"));
     }
     return new FloorNode(left->build(), right->build());
-}
\ No newline at end of file
+}
+
+// builds an equivalent node in the FlatTree
+FlatTree::Index Floor::build(FlatTree& tree)
+{
+    if (left == nullptr || right == nullptr) {
+        throw(std::invalid_argument("Required operands not given"));
+    }
+    auto lhs = left->build(tree);
+    auto rhs = right->build(tree);
+    return tree.makeBinary(FlatTree::Opcode::Floor, lhs, rhs);
+}
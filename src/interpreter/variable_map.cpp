@@ -1,37 +1,108 @@
 /* Copyright G. Hemingway @ 2022, All Rights Reserved */
 #include "interpreter/variable_map.h"
+#include <algorithm>
 #include <iostream>
+#include <utility>
+
+// copy the variables, keying the slots by the copied names
+VariableMap::VariableMap(const VariableMap& other)
+    : names(other.names)
+    , slotValues(other.slotValues)
+    , assigned(other.assigned)
+    , assignedCount(other.assignedCount)
+{
+    slots.reserve(names.size());
+    for (std::size_t i = 0; i < names.size(); ++i)
+        slots.emplace(names[i], static_cast<int>(i));
+}
+
+// copy the variables over this map's own
+VariableMap& VariableMap::operator=(const VariableMap& other)
+{
+    if (this != &other)
+        *this = VariableMap(other);
+    return *this;
+}
+
+// return the slot of a variable, interning it if necessary
+int VariableMap::slot(std::string_view name)
+{
+    auto iter = slots.find(name);
+    if (iter != slots.end())
+        return iter->second;
+
+    int slot = static_cast<int>(names.size());
+    names.emplace_back(name);
+    slots.emplace(names.back(), slot);
+    slotValues.push_back(0);
+    assigned.push_back(false);
+    return slot;
+}
+
+// return the slot of a variable without interning it
+int VariableMap::find(std::string_view name) const
+{
+    auto iter = slots.find(name);
+    return iter == slots.end() ? -1 : iter->second;
+}
+
+// return the name of the variable in a slot
+const std::string& VariableMap::name(int slot) const
+{
+    return names.at(slot);
+}
 
 // return the value of a variable
-int VariableMap::get(const std::string& name) const
+int VariableMap::get(std::string_view name) const
 {
-    auto iter = map.find(name);
-    if (iter == map.end())
+    auto iter = slots.find(name);
+    if (iter == slots.end())
         throw std::logic_error("Unknown variable");
-    return (*iter).second;
+    return get(iter->second);
+}
+
+// return the value of the variable in a slot
+int VariableMap::get(int slot) const
+{
+    if (slot < 0 || static_cast<std::size_t>(slot) >= assigned.size() || !assigned[slot])
+        throw std::logic_error("Unknown variable");
+    return slotValues[slot];
+}
+
+// return the values of all the variables
+const int* VariableMap::values() const
+{
+    return slotValues.data();
 }
 
 // set the value of a variable
-void VariableMap::set(const std::string& name, int value)
+void VariableMap::set(std::string_view name, int value)
 {
-    map[name] = value;
+    int index = slot(name);
+    if (!assigned[index]) {
+        assigned[index] = true;
+        ++assignedCount;
+    }
+    slotValues[index] = value;
 }
 
 // Have any variables been declared?
 [[maybe_unused]] bool VariableMap::isEmpty() const
 {
-    return map.empty();
+    return assignedCount == 0;
 }
 
 // print all variables and their values
-void VariableMap::print(std::ostream& os) const
+void VariableMap::print(OutputSink& os) const
 {
-    for (const auto& i : map)
-        os << i.first << "=" << i.second << std::endl;
+    for (std::size_t i = 0; i < names.size(); ++i)
+        if (assigned[i])
+            os << names[i] << '=' << slotValues[i] << '\n';
 }
 
 // clear all variables and their values
 [[maybe_unused]] void VariableMap::reset()
 {
-    map.clear();
+    std::fill(assigned.begin(), assigned.end(), false);
+    assignedCount = 0;
 }
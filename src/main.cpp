@@ -1,7 +1,31 @@
 /* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "core/acceptor.h"
+#include "core/batch_processor.h"
+#include "core/command_executor.h"
 #include "core/event_handler.h"
+#include "core/latency_stats.h"
 #include "core/options.h"
 #include "core/reactor.h"
+#include "core/signal_handler.h"
+#include "core/tracer.h"
+#include "core/work_stealing_pool.h"
+#include <fstream>
+#include <iostream>
+
+// Number of spans kept for the trace written on exit.
+static constexpr std::size_t traceCapacity = 1 << 16;
+
+// Write the trace, if there is one.
+static void writeTrace(const std::string& path)
+{
+    if (path.empty())
+        return;
+    try {
+        Tracer::instance()->write(path);
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
 
 int main(int argc, char* argv[])
 {
@@ -12,11 +36,65 @@ int main(int argc, char* argv[])
     if (!options->parseArgs(argc, argv))
         std::terminate();
 
+    // Create LatencyStats singleton, which only measures anything when asked to.
+    std::unique_ptr<LatencyStats> stats(LatencyStats::instance());
+    stats->enable(options->stats());
+
+    // Create Tracer singleton, which only records anything when asked to.
+    std::unique_ptr<Tracer> tracer(Tracer::instance());
+    if (!options->trace().empty())
+        tracer->enable(traceCapacity);
+
+    // Evaluate large expressions on one pool of threads that every session shares.  It's
+    // created before the Reactor so it outlives every session's evaluators.
+    std::unique_ptr<WorkStealingPool> pool;
+    if (options->threads() > 0) {
+        pool = std::make_unique<WorkStealingPool>(options->threads());
+        WorkStealingPool::instance(pool.get());
+    }
+
+    // Run a script straight through, without the interactive event loop.
+    if (!options->script().empty()) {
+        // don't synchronize with stdio or flush the output on every read
+        std::ios::sync_with_stdio(false);
+        std::cin.tie(nullptr);
+
+        std::ifstream file;
+        if (options->script() != "-") {
+            file.open(options->script());
+            if (!file) {
+                std::cerr << "Can't open " << options->script() << std::endl;
+                return 1;
+            }
+        }
+
+        BatchProcessor batch(file.is_open() ? file : std::cin, std::cout, options->verbose());
+        auto errors = batch.run();
+        writeTrace(options->trace());
+        return errors == 0 ? 0 : 1;
+    }
+
     // Create Reactor singleton to run application event loop.
     std::unique_ptr<Reactor> reactor(Reactor::instance());
 
-    // Dynamically allocate the appropriate event handler based on the command-line options.
-    EventHandler* handler = EventHandler::makeHandler(options->verbose(), std::cout);
+    // A server shuts down cleanly when it's told to terminate.  This has to come before
+    // any worker thread is started.
+    if (!options->server().empty())
+        reactor->registerHandler(new SignalHandler);
+
+    // Execute commands on worker threads if asked to.  This is registered first so it's
+    // destroyed first, and no worker is still running a command when the sessions go.
+    if (options->workers() > 0)
+        reactor->registerHandler(new CommandExecutor(options->workers()));
+
+    // Dynamically allocate the appropriate event handler based on the command-line options:
+    // either one that accepts clients on a socket, or one that serves the standard input.
+    Handler* handler;
+    if (!options->server().empty())
+        handler = new Acceptor(options->server(), options->verbose(),
+            std::chrono::seconds(options->idleTimeout()));
+    else
+        handler = EventHandler::makeHandler(options->verbose(), std::cout);
 
     // Register the event handler with the reactor.  The reactor is responsible for
     // triggering the deletion of the event handler
@@ -25,6 +103,7 @@ int main(int argc, char* argv[])
     // Run the reactor's event loop, which drives all the processing
     // via callbacks to registered event handlers.
     reactor->runEventLoop();
+    writeTrace(options->trace());
 
     // The std::unique_ptr destructors automatically destroy the singletons.
     return 0;
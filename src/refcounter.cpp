@@ -3,6 +3,7 @@
 #define REFCOUNTER_CPP
 
 #include "refcounter.h"
+#include <utility>
 
 // default Ctor
 template <typename T>
@@ -14,8 +15,9 @@ Refcounter<T>::Refcounter()
 // Ctor with refcounting functionality
 template <typename T>
 Refcounter<T>::Refcounter(T* ptr, bool increase_count)
-    : ptr(new Shim(ptr))
+    : ptr(ptr)
 {
+    increment();
     if (increase_count)
         increment();
 }
@@ -28,95 +30,103 @@ Refcounter<T>::Refcounter(const Refcounter& rhs)
     increment();
 }
 
+// move Ctor takes over the reference of rhs
+template <typename T>
+Refcounter<T>::Refcounter(Refcounter&& rhs) noexcept
+    : ptr(std::exchange(rhs.ptr, nullptr))
+{
+}
+
 // Dtor will delete pointer if refcount becomes 0
 template <typename T> Refcounter<T>::~Refcounter()
 {
     decrement();
 }
 
-// assignment operator for times when you don't want the reference
-// increased for incoming ptr.
-template <typename T> Refcounter<T>& Refcounter<T>::operator=(T* ptr)
+// assignment operator from a raw pointer, which takes a reference to
+// it.
+template <typename T> Refcounter<T>& Refcounter<T>::operator=(T* rhs)
 {
+    if (rhs)
+        rhs->increment();
     decrement();
-    ptr = new Shim(ptr);
+    ptr = rhs;
     return *this;
 }
 
 // assignment operator
 template <typename T> Refcounter<T>& Refcounter<T>::operator=(const Refcounter& rhs)
 {
-    decrement();
+    // take the new reference first in case rhs refers to our object
+    T* old = ptr;
     ptr = rhs.ptr;
     increment();
+    if (old && old->decrement())
+        delete old;
+    return *this;
+}
+
+// move assignment operator
+template <typename T> Refcounter<T>& Refcounter<T>::operator=(Refcounter&& rhs) noexcept
+{
+    if (this != &rhs) {
+        decrement();
+        ptr = std::exchange(rhs.ptr, nullptr);
+    }
     return *this;
 }
 
 // get the underlying pointer
 template <typename T> T* Refcounter<T>::get_ptr()
 {
-    return ptr->t;
+    return ptr;
 }
 
 // get the underlying pointer
 template <typename T> const T* Refcounter<T>::get_ptr() const
 {
-    return ptr->t;
+    return ptr;
 }
 
 // dereference operator
 template <typename T> T& Refcounter<T>::operator*()
 {
-    return *ptr->t;
+    return *ptr;
 }
 
 // dereference operator
 template <typename T> const T& Refcounter<T>::operator*() const
 {
-    return *ptr->t;
+    return *ptr;
 }
 
 // mimic pointer dereferencing
 template <typename T> T* Refcounter<T>::operator->()
 {
-    return ptr->t;
+    return ptr;
 }
 
 // mimic pointer dereferencing
 template <typename T> const T* Refcounter<T>::operator->() const
 {
-    return ptr->t;
+    return ptr;
 }
 
 // implementation of the increment operation
 template <typename T> void Refcounter<T>::increment()
 {
     if (ptr)
-        ++ptr->refcount;
+        ptr->increment();
 }
 
 // implementation of the decrement operation
 template <typename T> void Refcounter<T>::decrement()
 {
     if (ptr) {
-        --ptr->refcount;
-        if (ptr->refcount <= 0) {
+        if (ptr->decrement())
             delete ptr;
-            ptr = nullptr;
-        }
+        ptr = nullptr;
     }
 }
 
-template <typename T>
-Refcounter<T>::Shim::Shim(T* t)
-    : t(t)
-    , refcount(1)
-{
-}
-
-template <typename T> Refcounter<T>::Shim::~Shim()
-{
-    delete t;
-}
-
 #endif // REFCOUNTER_CPP
@@ -0,0 +1,327 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "tree/bytecode.h"
+#include "interpreter/variable_map.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// Number of values that fit on the interpreter's stack-allocated
+// value stack; deeper programs fall back to a heap buffer.
+static constexpr std::size_t inlineStackDepth = 64;
+
+// Number of rows runBatch() pushes through each instruction at once.
+// Every kernel loop runs over exactly this many rows, which lets the
+// compiler vectorize it without a scalar remainder loop.
+static constexpr std::size_t batchRows = 256;
+
+// Ctor
+Bytecode::Bytecode()
+    : code()
+    , depth(0)
+    , maxDepth(0)
+    , temps(0)
+{
+}
+
+// append an instruction, tracking the effect it has on the stack depth
+void Bytecode::emit(Opcode opcode, int operand)
+{
+    code.push_back({ opcode, operand });
+
+    switch (opcode) {
+    case Opcode::PushConst:
+        ++depth;
+        break;
+    case Opcode::PushVar:
+        ++depth;
+        if (static_cast<std::size_t>(operand) >= reads.size())
+            reads.resize(operand + 1, false);
+        if (!reads[operand]) {
+            reads[operand] = true;
+            slots.push_back(operand);
+        }
+        break;
+    case Opcode::Load:
+        ++depth;
+        if (static_cast<std::size_t>(operand) >= temps)
+            temps = operand + 1;
+        break;
+    case Opcode::Save:
+        if (static_cast<std::size_t>(operand) >= temps)
+            temps = operand + 1;
+        break;
+    case Opcode::Negate:
+    case Opcode::Factorial:
+        break;
+    default:
+        // binary operators pop two values and push one
+        if (depth > 0)
+            --depth;
+        break;
+    }
+
+    if (depth > maxDepth)
+        maxDepth = depth;
+}
+
+// return the number of instructions
+std::size_t Bytecode::size() const
+{
+    return code.size();
+}
+
+// return the maximum depth of the value stack
+std::size_t Bytecode::stackDepth() const
+{
+    return maxDepth;
+}
+
+// Run the program.  The semantics of each operator match those of
+// EvaluationVisitor.
+bool Bytecode::run(const VariableMap& variables, int& result) const
+{
+    // Check every variable the program reads is set up front, so the
+    // loop below can read values straight out of the array.
+    for (auto slot : slots)
+        (void)variables.get(slot);
+    const int* values = variables.values();
+
+    int inlineStack[inlineStackDepth];
+    std::vector<int> heapStack;
+    int* stack = inlineStack;
+    if (maxDepth > inlineStackDepth) {
+        heapStack.resize(maxDepth);
+        stack = heapStack.data();
+    }
+
+    int inlineTemps[inlineStackDepth];
+    std::vector<int> heapTemps;
+    int* saved = inlineTemps;
+    if (temps > inlineStackDepth) {
+        heapTemps.resize(temps);
+        saved = heapTemps.data();
+    }
+
+    // top always points one past the topmost value
+    int* top = stack;
+
+    for (const auto& instruction : code) {
+        switch (instruction.opcode) {
+        case Opcode::PushConst:
+            *top++ = instruction.operand;
+            break;
+        case Opcode::PushVar:
+            *top++ = values[instruction.operand];
+            break;
+        case Opcode::Negate:
+            top[-1] = -top[-1];
+            break;
+        case Opcode::Add:
+            --top;
+            top[-1] += top[0];
+            break;
+        case Opcode::Subtract:
+            --top;
+            top[-1] -= top[0];
+            break;
+        case Opcode::Multiply:
+            --top;
+            top[-1] *= top[0];
+            break;
+        case Opcode::Divide:
+            --top;
+            if (top[0] == 0)
+                return false;
+            top[-1] /= top[0];
+            break;
+        case Opcode::Exponent:
+            --top;
+            top[-1] = static_cast<int>(pow(top[-1], top[0]));
+            break;
+        case Opcode::Modulus:
+            --top;
+            if (top[0] == 0)
+                throw std::invalid_argument("Cannot modulus by 0");
+            top[-1] %= top[0];
+            break;
+        case Opcode::Factorial:
+            if (top[-1] > 12)
+                throw std::invalid_argument("Factorials above 12 are not supported");
+            top[-1] = static_cast<int>(tgamma(top[-1] + 1));
+            break;
+        case Opcode::Ceiling:
+            --top;
+            if (top[0] > top[-1])
+                top[-1] = top[0];
+            break;
+        case Opcode::Floor:
+            --top;
+            if (top[0] < top[-1])
+                top[-1] = top[0];
+            break;
+        case Opcode::Save:
+            saved[instruction.operand] = top[-1];
+            break;
+        case Opcode::Load:
+            *top++ = saved[instruction.operand];
+            break;
+        }
+    }
+
+    result = top == stack ? 0 : top[-1];
+    return true;
+}
+
+// Run the program over blocks of rows.  The value stack holds one
+// block of batchRows values per entry, and each instruction combines
+// whole blocks.  Instructions that can trap, or that can't be
+// vectorized anyway, only look at the rows actually in use.
+void Bytecode::runBatch(const VariableMap& variables, const std::vector<const int*>& columns,
+    std::size_t rows, int* out, std::vector<std::size_t>& trapped) const
+{
+    // Variables without a column are broadcast from their current value.
+    for (auto slot : slots)
+        if (static_cast<std::size_t>(slot) >= columns.size() || !columns[slot])
+            (void)variables.get(slot);
+    const int* values = variables.values();
+
+    std::vector<int> stack(std::max<std::size_t>(maxDepth, 1) * batchRows);
+    std::vector<int> saved(temps * batchRows);
+    // whether each row of the block has divided by zero
+    std::vector<bool> trappedRows(batchRows);
+
+    for (std::size_t first = 0; first < rows; first += batchRows) {
+        std::size_t count = std::min(batchRows, rows - first);
+        // top always points one past the topmost block
+        int* top = stack.data();
+        std::fill(trappedRows.begin(), trappedRows.end(), false);
+
+        for (const auto& instruction : code) {
+            switch (instruction.opcode) {
+            case Opcode::PushConst:
+                std::fill_n(top, batchRows, instruction.operand);
+                top += batchRows;
+                break;
+            case Opcode::PushVar: {
+                auto slot = static_cast<std::size_t>(instruction.operand);
+                if (slot < columns.size() && columns[slot]) {
+                    std::copy_n(columns[slot] + first, count, top);
+                    std::fill(top + count, top + batchRows, 0);
+                } else
+                    std::fill_n(top, batchRows, values[slot]);
+                top += batchRows;
+                break;
+            }
+            case Opcode::Negate: {
+                int* __restrict a = top - batchRows;
+                for (std::size_t i = 0; i < batchRows; ++i)
+                    a[i] = -a[i];
+                break;
+            }
+            case Opcode::Add: {
+                top -= batchRows;
+                int* __restrict a = top - batchRows;
+                const int* __restrict b = top;
+                for (std::size_t i = 0; i < batchRows; ++i)
+                    a[i] += b[i];
+                break;
+            }
+            case Opcode::Subtract: {
+                top -= batchRows;
+                int* __restrict a = top - batchRows;
+                const int* __restrict b = top;
+                for (std::size_t i = 0; i < batchRows; ++i)
+                    a[i] -= b[i];
+                break;
+            }
+            case Opcode::Multiply: {
+                top -= batchRows;
+                int* __restrict a = top - batchRows;
+                const int* __restrict b = top;
+                for (std::size_t i = 0; i < batchRows; ++i)
+                    a[i] *= b[i];
+                break;
+            }
+            case Opcode::Divide: {
+                top -= batchRows;
+                int* a = top - batchRows;
+                const int* b = top;
+                // a row that traps carries on with a quotient of 1; its
+                // yield is discarded, so the instructions that can throw
+                // skip it
+                for (std::size_t i = 0; i < count; ++i)
+                    if (b[i])
+                        a[i] /= b[i];
+                    else {
+                        a[i] = 1;
+                        trappedRows[i] = true;
+                    }
+                break;
+            }
+            case Opcode::Exponent: {
+                top -= batchRows;
+                int* a = top - batchRows;
+                const int* b = top;
+                for (std::size_t i = 0; i < count; ++i)
+                    a[i] = static_cast<int>(pow(a[i], b[i]));
+                break;
+            }
+            case Opcode::Modulus: {
+                top -= batchRows;
+                int* a = top - batchRows;
+                const int* b = top;
+                for (std::size_t i = 0; i < count; ++i) {
+                    if (trappedRows[i])
+                        continue;
+                    if (b[i] == 0)
+                        throw std::invalid_argument("Cannot modulus by 0");
+                    a[i] %= b[i];
+                }
+                break;
+            }
+            case Opcode::Factorial: {
+                int* a = top - batchRows;
+                for (std::size_t i = 0; i < count; ++i) {
+                    if (trappedRows[i])
+                        continue;
+                    if (a[i] > 12)
+                        throw std::invalid_argument("Factorials above 12 are not supported");
+                    a[i] = static_cast<int>(tgamma(a[i] + 1));
+                }
+                break;
+            }
+            case Opcode::Ceiling: {
+                top -= batchRows;
+                int* __restrict a = top - batchRows;
+                const int* __restrict b = top;
+                for (std::size_t i = 0; i < batchRows; ++i)
+                    a[i] = std::max(a[i], b[i]);
+                break;
+            }
+            case Opcode::Floor: {
+                top -= batchRows;
+                int* __restrict a = top - batchRows;
+                const int* __restrict b = top;
+                for (std::size_t i = 0; i < batchRows; ++i)
+                    a[i] = std::min(a[i], b[i]);
+                break;
+            }
+            case Opcode::Save:
+                std::copy_n(top - batchRows, batchRows, saved.data() + instruction.operand * batchRows);
+                break;
+            case Opcode::Load:
+                std::copy_n(saved.data() + instruction.operand * batchRows, batchRows, top);
+                top += batchRows;
+                break;
+            }
+        }
+
+        if (top == stack.data())
+            std::fill_n(out + first, count, 0);
+        else
+            std::copy_n(top - batchRows, count, out + first);
+        for (std::size_t i = 0; i < count; ++i)
+            if (trappedRows[i])
+                trapped.push_back(first + i);
+    }
+}
@@ -1,12 +1,19 @@
 /* Copyright G. Hemingway @ 2022, All Rights Reserved */
 #include "tree/expression_tree.h"
+#include "core/tracer.h"
+#include "interpreter/variable_map.h"
 #include "tree/component_node.h"
 #include "tree/expression_tree_iterator.h"
 #include "tree/expression_tree_iterator_impl.h"
+#include "tree/tree_archive.h"
+#include "visitors/compile.h"
+#include "visitors/evaluation.h"
+#include "visitors/simplify.h"
 #include <algorithm>
 #include <map>
 #include <sstream>
 #include <stdexcept>
+#include <utility>
 
 /**
  * @class ExpressionTreeIteratorFactory
@@ -109,19 +116,67 @@ static ExpressionTreeIteratorFactory treeIteratorFactory;
 
 // Default ctor
 ExpressionTree::ExpressionTree()
-    : root(nullptr)
+    : root()
+    , node(nullptr)
+    , flat()
+    , index(FlatTree::npos)
 {
 }
 
 // Ctor take an underlying NODE*.
 ExpressionTree::ExpressionTree(ComponentNode* inRoot, const bool increment)
     : root(inRoot, increment)
+    , node(inRoot)
+    , flat()
+    , index(FlatTree::npos)
+{
+}
+
+// Ctor that takes ownership of a FlatTree.
+ExpressionTree::ExpressionTree(FlatTree* tree)
+    : root()
+    , node(nullptr)
+    , flat(tree)
+    , index(tree->root())
+{
+}
+
+// Ctor for a subtree of a shared FlatTree.  Sharing the Refcounter
+// keeps the whole arena alive and doesn't allocate.
+ExpressionTree::ExpressionTree(const Refcounter<FlatTree>& tree, FlatTree::Index index)
+    : root()
+    , node(nullptr)
+    , flat(tree)
+    , index(index)
+{
+}
+
+// Ctor for a subtree of a shared node tree.  Like the FlatTree case,
+// sharing the root's Refcounter keeps the whole tree alive and doesn't
+// allocate.
+ExpressionTree::ExpressionTree(const Refcounter<ComponentNode>& root, ComponentNode* node)
+    : root(root)
+    , node(node)
+    , flat()
+    , index(FlatTree::npos)
 {
 }
 
 // Copy ctor
 ExpressionTree::ExpressionTree(const ExpressionTree& rhs)
     : root(rhs.root)
+    , node(rhs.node)
+    , flat(rhs.flat)
+    , index(rhs.index)
+{
+}
+
+// Move ctor steals the references of rhs, leaving it a null tree
+ExpressionTree::ExpressionTree(ExpressionTree&& rhs) noexcept
+    : root(std::move(rhs.root))
+    , node(std::exchange(rhs.node, nullptr))
+    , flat(std::move(rhs.flat))
+    , index(std::exchange(rhs.index, FlatTree::npos))
 {
 }
 
@@ -130,45 +185,73 @@ ExpressionTree& ExpressionTree::operator=(const ExpressionTree& rhs)
 {
     // Refcounter class takes care of the internal decrements and
     // increments.
-    if (this != &rhs)
+    if (this != &rhs) {
         root = rhs.root;
+        node = rhs.node;
+        flat = rhs.flat;
+        index = rhs.index;
+    }
+    return *this;
+}
+
+// Move assignment operator
+ExpressionTree& ExpressionTree::operator=(ExpressionTree&& rhs) noexcept
+{
+    if (this != &rhs) {
+        root = std::move(rhs.root);
+        node = std::exchange(rhs.node, nullptr);
+        flat = std::move(rhs.flat);
+        index = std::exchange(rhs.index, FlatTree::npos);
+    }
     return *this;
 }
 
 bool ExpressionTree::operator==(const ExpressionTree& rhs) const
 {
-    return root.get_ptr() == rhs.root.get_ptr();
+    return node == rhs.node && flat.get_ptr() == rhs.flat.get_ptr() && index == rhs.index;
+}
+
+bool ExpressionTree::operator!=(const ExpressionTree& rhs) const
+{
+    return !(*this == rhs);
 }
 
 // Check if the tree is empty.
 bool ExpressionTree::isNull() const
 {
-    return root.get_ptr() == nullptr;
+    if (flat.get_ptr())
+        return index == FlatTree::npos;
+    return node == nullptr;
 }
 
 // return root pointer
 ComponentNode* ExpressionTree::getRoot()
 {
-    return root.get_ptr();
+    return node;
 }
 
 // Return the stored item.
 int ExpressionTree::item() const
 {
-    return root->item();
+    if (flat.get_ptr())
+        return flat->item(index);
+    return node->item();
 }
 
 // Return the left branch.
 ExpressionTree ExpressionTree::left()
 {
-    return ExpressionTree(root->left(), true);
+    if (flat.get_ptr())
+        return ExpressionTree(flat, flat->left(index));
+    return ExpressionTree(root, node->left());
 }
 
 // Return the left branch.
 ExpressionTree ExpressionTree::right()
 {
-    auto rt = root->right();
-    return ExpressionTree(rt, true);
+    if (flat.get_ptr())
+        return ExpressionTree(flat, flat->right(index));
+    return ExpressionTree(root, node->right());
 }
 
 // Return a begin iterator of a specified type.
@@ -212,5 +295,96 @@ ExpressionTreeConstIterator ExpressionTree::end(const std::string& traversal_ord
 // Accept a visitor to perform some action on the Expression_Tree.
 void ExpressionTree::accept(Visitor& visitor) const
 {
-    root->accept(visitor);
+    if (flat.get_ptr())
+        flat->accept(index, visitor);
+    else
+        node->accept(visitor);
+}
+
+// Compile the tree by visiting its nodes in post-order.  A FlatTree
+// compiles itself instead, so that nodes it shares are computed once.
+Bytecode ExpressionTree::compile() const
+{
+    Tracer::Span span("compile", "visitor");
+    Bytecode program;
+    if (flat.get_ptr())
+        program = flat->compile(index);
+    else {
+        CompileVisitor visitor;
+        std::for_each(begin("post-order"), end("post-order"),
+            [&visitor](auto node) { node.accept(visitor); });
+        program = visitor.program();
+    }
+    span.count("instructions", static_cast<std::int64_t>(program.size()));
+    return program;
+}
+
+// Simplify the tree by visiting its nodes in post-order.
+ExpressionTree ExpressionTree::simplify(std::size_t& removed, bool share) const
+{
+    Tracer::Span span("simplify", "visitor");
+    SimplifyVisitor visitor;
+    std::for_each(
+        begin("post-order"), end("post-order"), [&visitor](auto node) { node.accept(visitor); });
+    removed = visitor.removed();
+    span.count("removed", static_cast<std::int64_t>(removed));
+    return visitor.tree(share);
+}
+
+// Evaluate the tree over columns of variable values.
+std::vector<int> ExpressionTree::evaluateBatch(const VariableMap& variables,
+    const std::unordered_map<std::string, std::vector<int>>& columns) const
+{
+    std::size_t rows = columns.empty() ? 1 : columns.begin()->second.size();
+
+    // Line the columns up by slot; columns for variables the tree never
+    // mentions are simply not interned and can be skipped.
+    std::vector<const int*> slots;
+    for (const auto& column : columns) {
+        if (column.second.size() != rows)
+            throw std::invalid_argument("Columns must all be the same length");
+        int slot = variables.find(column.first);
+        if (slot < 0)
+            continue;
+        if (static_cast<std::size_t>(slot) >= slots.size())
+            slots.resize(slot + 1, nullptr);
+        slots[slot] = column.second.data();
+    }
+
+    std::vector<int> results(rows);
+    std::vector<std::size_t> trapped;
+    compile().runBatch(variables, slots, rows, results.data(), trapped);
+
+    // Rows that divide by zero are evaluated on their own, the way a
+    // single evaluation falls back to an EvaluationVisitor.
+    if (!trapped.empty()) {
+        VariableMap row(variables);
+        for (auto index : trapped) {
+            for (const auto& column : columns)
+                if (row.find(column.first) >= 0)
+                    row.set(column.first, column.second[index]);
+            EvaluationVisitor visitor(row);
+            std::for_each(begin("post-order"), end("post-order"),
+                [&visitor](auto node) { node.accept(visitor); });
+            results[index] = visitor.total();
+        }
+    }
+    return results;
+}
+
+// Save the tree as a one-tree archive.
+void ExpressionTree::save(std::ostream& os, const VariableMap& variables) const
+{
+    TreeWriter writer(variables);
+    writer.add(*this);
+    writer.write(os);
+}
+
+// Load the first tree of an archive.
+ExpressionTree ExpressionTree::load(std::istream& is, VariableMap& variables)
+{
+    TreeArchive archive(is, variables);
+    if (archive.size() == 0)
+        throw TreeArchive::InvalidArchive("Empty expression archive");
+    return archive.tree(0);
 }
@@ -82,10 +82,7 @@ bool InOrderExpressionTreeIteratorImpl::operator==(const ExpressionTreeIteratorI
         // to assume the queue at least has a front node (coupled with
         // the is_empty () function later).
 
-        auto t1 = const_cast<ExpressionTree&>(tree);
-        auto t2 = const_cast<ExpressionTree&>(inOrderRhs->tree);
-
-        if (t1.getRoot() == t2.getRoot() && stack.size() == inOrderRhs->stack.size()) {
+        if (tree == inOrderRhs->tree && stack.size() == inOrderRhs->stack.size()) {
             // Check for both being empty (special condition).
             if (stack.empty() && inOrderRhs->stack.empty())
                 return true;
@@ -182,10 +179,7 @@ bool PreOrderExpressionTreeIteratorImpl::operator==(const ExpressionTreeIterator
         // to assume the queue at least has a front node (coupled with
         // the is_empty () function later).
 
-        auto t1 = const_cast<ExpressionTree&>(tree);
-        auto t2 = const_cast<ExpressionTree&>(pre_order_rhs->tree);
-
-        if (t1.getRoot() == t2.getRoot() && stack.size() == pre_order_rhs->stack.size()) {
+        if (tree == pre_order_rhs->tree && stack.size() == pre_order_rhs->stack.size()) {
             // check for both being is_empty (special condition)
             if (stack.empty() && pre_order_rhs->stack.empty())
                 return true;
@@ -230,76 +224,47 @@ PostOrderExpressionTreeIteratorImpl::PostOrderExpressionTreeIteratorImpl(
     // if the caller doesn't want an end iterator, insert the root tree
     // into the queue.
     if (!end_iter && !tree.isNull()) {
-        ExpressionTree current = const_cast<ExpressionTree&>(tree);
-        stack.push(current);
-
-        // the commented code does not work on unary operator nodes with no left
-        // child, but
-        // a right child - or at least, there is a certain depth that this will not
-        // go down
-
-        while (!current.isNull()) {
-            if (!current.right().isNull())
-                stack.push(current.right());
-            if (!current.left().isNull()) {
-                // if there was a left, then update current
-                // this is the case for all non-negations
-                stack.push(current.left());
-                current = current.left();
-            } else
-                // if there was not a left, then current = current->right_
-                // this handles cases of unary nodes, like negations
-                current = current.right();
-        }
+        stack.push({ tree, false });
+        descend();
+    }
+}
+
+// Pushes the right child before the left, so the left is visited
+// first.  Unary nodes, like negations, only have a right child.
+void PostOrderExpressionTreeIteratorImpl::descend()
+{
+    while (!stack.top().second) {
+        stack.top().second = true;
+        ExpressionTree current = stack.top().first;
+        if (!current.right().isNull())
+            stack.push({ current.right(), false });
+        if (!current.left().isNull())
+            stack.push({ current.left(), false });
     }
 }
 
 // Returns the Node that the iterator is pointing to (non-const version)
 ExpressionTree PostOrderExpressionTreeIteratorImpl::operator*()
 {
-    return stack.top();
+    return stack.top().first;
 }
 
 // Returns the Node that the iterator is pointing to (const version)
 const ExpressionTree PostOrderExpressionTreeIteratorImpl::operator*() const
 {
-    return stack.top();
+    return stack.top().first;
 }
 
 // moves the iterator to the next node (pre-increment)
 void PostOrderExpressionTreeIteratorImpl::operator++()
 {
-    // we know that at this point there is no left () of top ()
-    // because we would have already visited it.
-
+    // The node on top has been visited.  Below it is either its parent,
+    // whose children have all been visited now, or a sibling still to
+    // be descended into.
     if (!stack.empty()) {
-        // we need to pop the node off the stack before pushing the
-        // children, or else we'll revisit this node later
-
-        ExpressionTree current = stack.top();
         stack.pop();
-
-        // This is where stuff gets a little confusing.
-
-        if (!stack.empty() && stack.top().left().getRoot() != current.getRoot()
-            && stack.top().right().getRoot() != current.getRoot()) {
-            current = stack.top();
-
-            while (!current.isNull()) {
-                if (!current.right().isNull())
-                    stack.push(current.right());
-                if (!current.left().isNull()) {
-                    // if there was a left, then update current
-                    // this is the case for all non-negations
-                    stack.push(current.left());
-                    current = current.left();
-                } else {
-                    // if there was not a left, then current = current->right_
-                    // this handles cases of unary nodes, like negations
-                    current = current.right();
-                }
-            }
-        }
+        if (!stack.empty())
+            descend();
     }
 }
 
@@ -320,10 +285,7 @@ bool PostOrderExpressionTreeIteratorImpl::operator==(const ExpressionTreeIterato
         // to assume the queue at least has a front node (coupled with
         // the is_empty () function later).
 
-        auto t1 = const_cast<ExpressionTree&>(tree);
-        auto t2 = const_cast<ExpressionTree&>(postOrderRhs->tree);
-
-        if (t1.getRoot() == t2.getRoot() && stack.size() == postOrderRhs->stack.size()) {
+        if (tree == postOrderRhs->tree && stack.size() == postOrderRhs->stack.size()) {
             // check for both being is_empty (special condition)
             if (stack.empty() && postOrderRhs->stack.empty())
                 return true;
@@ -332,7 +294,7 @@ bool PostOrderExpressionTreeIteratorImpl::operator==(const ExpressionTreeIterato
             // equal, then both iterators are pointing to the same
             // position in the tree.
 
-            if (stack.top() == postOrderRhs->stack.top())
+            if (stack.top().first == postOrderRhs->stack.top().first)
                 return true;
         }
     }
@@ -417,10 +379,7 @@ bool LevelOrderExpressionTreeIteratorImpl::operator==(const ExpressionTreeIterat
         // to assume the queue at least has a front node (coupled with
         // the is_empty () function later).
 
-        auto t1 = const_cast<ExpressionTree&>(tree);
-        auto t2 = const_cast<ExpressionTree&>(level_order_rhs->tree);
-
-        if (t1.getRoot() == t2.getRoot() && queue.size() == level_order_rhs->queue.size()) {
+        if (tree == level_order_rhs->tree && queue.size() == level_order_rhs->queue.size()) {
             // check for both being is_empty (special condition)
             if (queue.empty() && level_order_rhs->queue.empty())
                 return true;
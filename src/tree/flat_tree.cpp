@@ -0,0 +1,320 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "tree/flat_tree.h"
+#include "tree/add_node.h"
+#include "tree/bytecode.h"
+#include "tree/ceiling_node.h"
+#include "tree/divide_node.h"
+#include "tree/exponent_node.h"
+#include "tree/factorial_node.h"
+#include "tree/floor_node.h"
+#include "tree/leaf_node.h"
+#include "tree/modulus_node.h"
+#include "tree/multiply_node.h"
+#include "tree/negate_node.h"
+#include "tree/subtract_node.h"
+#include "tree/variable_node.h"
+#include "visitors/visitor.h"
+#include <stdexcept>
+
+// Ctor
+FlatTree::FlatTree(bool share)
+    : share(share)
+{
+}
+
+// hash all the fields of a node
+std::size_t FlatTree::NodeHash::operator()(const Node& node) const
+{
+    std::uint64_t hash = (std::uint64_t(node.left) << 32) | node.right;
+    hash ^= std::uint64_t(static_cast<std::uint32_t>(node.payload)) << 8
+        | static_cast<std::uint8_t>(node.opcode);
+    // mix the bits so nearby indices don't collide (splitmix64 finalizer)
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    return static_cast<std::size_t>(hash ^ (hash >> 31));
+}
+
+// compare all the fields of two nodes
+bool FlatTree::NodeEqual::operator()(const Node& lhs, const Node& rhs) const
+{
+    return lhs.opcode == rhs.opcode && lhs.payload == rhs.payload && lhs.left == rhs.left
+        && lhs.right == rhs.right;
+}
+
+// append a node, unless sharing finds an identical one.  Children are
+// interned before their parents, so comparing child indices compares
+// whole subtrees.
+FlatTree::Index FlatTree::append(const Node& node)
+{
+    auto index = static_cast<Index>(nodes.size());
+    if (share) {
+        auto result = interned.emplace(node, index);
+        if (!result.second)
+            return result.first->second;
+    }
+    nodes.push_back(node);
+    return index;
+}
+
+// reserve room for nodes
+void FlatTree::reserve(std::size_t count)
+{
+    nodes.reserve(count);
+}
+
+// append a leaf node
+FlatTree::Index FlatTree::makeLeaf(int value)
+{
+    return append({ Opcode::Number, value, npos, npos });
+}
+
+// append a variable leaf, remembering its name for printing
+FlatTree::Index FlatTree::makeVariable(std::string_view name, int slot)
+{
+    if (static_cast<std::size_t>(slot) >= names.size())
+        names.resize(slot + 1);
+    // only copy the name the first time the variable appears
+    if (names[slot].empty())
+        names[slot] = name;
+    return append({ Opcode::Variable, slot, npos, npos });
+}
+
+// append a unary node, whose only child is kept on the right just
+// like UnaryNode does
+FlatTree::Index FlatTree::makeUnary(Opcode opcode, Index child)
+{
+    return append({ opcode, 0, npos, child });
+}
+
+// append a binary node
+FlatTree::Index FlatTree::makeBinary(Opcode opcode, Index left, Index right)
+{
+    return append({ opcode, 0, left, right });
+}
+
+// return the number of nodes
+std::size_t FlatTree::size() const
+{
+    return nodes.size();
+}
+
+// check for an empty tree
+bool FlatTree::empty() const
+{
+    return nodes.empty();
+}
+
+// the root is always the last node added
+FlatTree::Index FlatTree::root() const
+{
+    return nodes.empty() ? npos : static_cast<Index>(nodes.size() - 1);
+}
+
+// return a node
+const FlatTree::Node& FlatTree::node(Index index) const
+{
+    return nodes[index];
+}
+
+// return the name of a variable
+const std::string& FlatTree::name(int slot) const
+{
+    return names[slot];
+}
+
+// return the item stored in a node
+int FlatTree::item(Index index) const
+{
+    switch (nodes[index].opcode) {
+    case Opcode::Number:
+    case Opcode::Variable:
+        return nodes[index].payload;
+    case Opcode::Negate:
+    case Opcode::Subtract:
+        return '-';
+    case Opcode::Add:
+        return '+';
+    case Opcode::Multiply:
+        return '*';
+    case Opcode::Divide:
+        return '/';
+    case Opcode::Exponent:
+        return '^';
+    case Opcode::Modulus:
+        return '%';
+    case Opcode::Factorial:
+        return '!';
+    case Opcode::Ceiling:
+        return '|';
+    case Opcode::Floor:
+        return '_';
+    }
+    throw std::logic_error("Unknown opcode");
+}
+
+// return the left child index
+FlatTree::Index FlatTree::left(Index index) const
+{
+    return nodes[index].left;
+}
+
+// return the right child index
+FlatTree::Index FlatTree::right(Index index) const
+{
+    return nodes[index].right;
+}
+
+// Visitors only look at the type of operator nodes (and at the item
+// of leaves), so each node is presented as a childless prototype of
+// the matching ComponentNode subclass.  None of this allocates.
+void FlatTree::accept(Index index, Visitor& visitor) const
+{
+    static const NegateNode negateNode(nullptr);
+    static const AddNode addNode(nullptr, nullptr);
+    static const SubtractNode subtractNode(nullptr, nullptr);
+    static const MultiplyNode multiplyNode(nullptr, nullptr);
+    static const DivideNode divideNode(nullptr, nullptr);
+    static const ExponentNode exponentNode(nullptr, nullptr);
+    static const ModulusNode modulusNode(nullptr, nullptr);
+    static const FactorialNode factorialNode(nullptr);
+    static const CeilingNode ceilingNode(nullptr, nullptr);
+    static const FloorNode floorNode(nullptr, nullptr);
+
+    switch (nodes[index].opcode) {
+    case Opcode::Number: {
+        LeafNode leaf(nodes[index].payload);
+        visitor.visit(leaf);
+        break;
+    }
+    case Opcode::Variable: {
+        VariableNode variable(names[nodes[index].payload], nodes[index].payload);
+        visitor.visit(variable);
+        break;
+    }
+    case Opcode::Negate:
+        visitor.visit(negateNode);
+        break;
+    case Opcode::Add:
+        visitor.visit(addNode);
+        break;
+    case Opcode::Subtract:
+        visitor.visit(subtractNode);
+        break;
+    case Opcode::Multiply:
+        visitor.visit(multiplyNode);
+        break;
+    case Opcode::Divide:
+        visitor.visit(divideNode);
+        break;
+    case Opcode::Exponent:
+        visitor.visit(exponentNode);
+        break;
+    case Opcode::Modulus:
+        visitor.visit(modulusNode);
+        break;
+    case Opcode::Factorial:
+        visitor.visit(factorialNode);
+        break;
+    case Opcode::Ceiling:
+        visitor.visit(ceilingNode);
+        break;
+    case Opcode::Floor:
+        visitor.visit(floorNode);
+        break;
+    }
+}
+
+// Translate a node's opcode to the matching instruction.
+static Bytecode::Opcode instruction(FlatTree::Opcode opcode)
+{
+    switch (opcode) {
+    case FlatTree::Opcode::Number:
+        return Bytecode::Opcode::PushConst;
+    case FlatTree::Opcode::Variable:
+        return Bytecode::Opcode::PushVar;
+    case FlatTree::Opcode::Negate:
+        return Bytecode::Opcode::Negate;
+    case FlatTree::Opcode::Add:
+        return Bytecode::Opcode::Add;
+    case FlatTree::Opcode::Subtract:
+        return Bytecode::Opcode::Subtract;
+    case FlatTree::Opcode::Multiply:
+        return Bytecode::Opcode::Multiply;
+    case FlatTree::Opcode::Divide:
+        return Bytecode::Opcode::Divide;
+    case FlatTree::Opcode::Exponent:
+        return Bytecode::Opcode::Exponent;
+    case FlatTree::Opcode::Modulus:
+        return Bytecode::Opcode::Modulus;
+    case FlatTree::Opcode::Factorial:
+        return Bytecode::Opcode::Factorial;
+    case FlatTree::Opcode::Ceiling:
+        return Bytecode::Opcode::Ceiling;
+    case FlatTree::Opcode::Floor:
+        return Bytecode::Opcode::Floor;
+    }
+    throw std::logic_error("Unknown opcode");
+}
+
+// Compile a subtree, computing shared nodes only once.  The nodes are
+// emitted in post-order off an explicit stack, since a long chain of
+// operators is far deeper than the call stack allows.  The first time a
+// shared operator node is emitted its value is saved in a temporary,
+// and every later reference just loads it back.
+Bytecode FlatTree::compile(Index index) const
+{
+    Bytecode program;
+    if (index == npos)
+        return program;
+
+    // Count the parents of every node reachable from index.  Parents
+    // always come after their children, so one backwards pass will do.
+    std::vector<std::uint32_t> uses(index + 1, 0);
+    uses[index] = 1;
+    for (Index i = index + 1; i-- > 0;) {
+        if (!uses[i])
+            continue;
+        if (nodes[i].left != npos)
+            ++uses[nodes[i].left];
+        if (nodes[i].right != npos)
+            ++uses[nodes[i].right];
+    }
+
+    std::vector<int> saved(index + 1, -1);
+    int temps = 0;
+
+    // each node on the stack, and whether its children have been pushed
+    std::vector<std::pair<Index, bool>> stack;
+    stack.emplace_back(index, false);
+    while (!stack.empty()) {
+        auto& [current, expanded] = stack.back();
+        const auto& node = nodes[current];
+
+        if (!expanded) {
+            if (saved[current] >= 0) {
+                program.emit(Bytecode::Opcode::Load, saved[current]);
+                stack.pop_back();
+                continue;
+            }
+            // the left child is pushed last so it's emitted first
+            expanded = true;
+            auto left = node.left;
+            auto right = node.right;
+            if (right != npos)
+                stack.emplace_back(right, false);
+            if (left != npos)
+                stack.emplace_back(left, false);
+            continue;
+        }
+
+        program.emit(instruction(node.opcode), node.payload);
+        // leaves are as cheap to push again as to load
+        bool leaf = node.opcode == Opcode::Number || node.opcode == Opcode::Variable;
+        if (uses[current] > 1 && !leaf) {
+            saved[current] = temps++;
+            program.emit(Bytecode::Opcode::Save, saved[current]);
+        }
+        stack.pop_back();
+    }
+    return program;
+}
@@ -0,0 +1,221 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "tree/incremental_evaluator.h"
+#include "interpreter/variable_map.h"
+#include "tree/expression_tree.h"
+#include "tree/expression_tree_iterator.h"
+#include "tree/leaf_node.h"
+#include "tree/variable_node.h"
+#include "visitors/visitor.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+/**
+ * @class Recorder
+ * @brief This plays the role of a visitor that records the nodes of an
+ *        expression tree that is being iterated in post-order fashion,
+ *        linking each node to its children and parent.
+ */
+class IncrementalEvaluator::Recorder : public Visitor {
+public:
+    explicit Recorder(std::vector<Node>& nodes)
+        : nodes(nodes)
+    {
+    }
+
+    void visit(const LeafNode& node) override
+    {
+        leaf(FlatTree::Opcode::Number, node.item());
+    }
+    void visit(const VariableNode& node) override
+    {
+        leaf(FlatTree::Opcode::Variable, node.item());
+    }
+    void visit(const NegateNode&) override { unary(FlatTree::Opcode::Negate); }
+    void visit(const AddNode&) override { binary(FlatTree::Opcode::Add); }
+    void visit(const SubtractNode&) override { binary(FlatTree::Opcode::Subtract); }
+    void visit(const DivideNode&) override { binary(FlatTree::Opcode::Divide); }
+    void visit(const MultiplyNode&) override { binary(FlatTree::Opcode::Multiply); }
+    void visit(const ExponentNode&) override { binary(FlatTree::Opcode::Exponent); }
+    void visit(const ModulusNode&) override { binary(FlatTree::Opcode::Modulus); }
+    void visit(const FactorialNode&) override { unary(FlatTree::Opcode::Factorial); }
+    void visit(const CeilingNode&) override { binary(FlatTree::Opcode::Ceiling); }
+    void visit(const FloorNode&) override { binary(FlatTree::Opcode::Floor); }
+
+private:
+    // append a node, making it the parent of its children
+    void append(FlatTree::Opcode opcode, int payload, FlatTree::Index left, FlatTree::Index right)
+    {
+        auto index = static_cast<FlatTree::Index>(nodes.size());
+        if (left != FlatTree::npos)
+            nodes[left].parent = index;
+        if (right != FlatTree::npos)
+            nodes[right].parent = index;
+        nodes.push_back({ opcode, payload, left, right, FlatTree::npos });
+        stack.push_back(index);
+    }
+
+    void leaf(FlatTree::Opcode opcode, int payload)
+    {
+        append(opcode, payload, FlatTree::npos, FlatTree::npos);
+    }
+
+    // unary nodes keep their child on the right, like UnaryNode does
+    void unary(FlatTree::Opcode opcode)
+    {
+        auto child = pop();
+        append(opcode, 0, FlatTree::npos, child);
+    }
+
+    void binary(FlatTree::Opcode opcode)
+    {
+        auto right = pop();
+        auto left = pop();
+        append(opcode, 0, left, right);
+    }
+
+    FlatTree::Index pop()
+    {
+        if (stack.empty())
+            throw std::invalid_argument("Required operands not given");
+        auto index = stack.back();
+        stack.pop_back();
+        return index;
+    }
+
+    std::vector<Node>& nodes;
+    // Nodes that still need a parent.
+    std::vector<FlatTree::Index> stack;
+};
+
+// Ctor
+IncrementalEvaluator::IncrementalEvaluator(const ExpressionTree& tree)
+    : lastRecomputed(0)
+{
+    if (!tree.isNull()) {
+        Recorder recorder(nodes);
+        std::for_each(tree.begin("post-order"), tree.end("post-order"),
+            [&recorder](auto node) { node.accept(recorder); });
+    }
+
+    values.resize(nodes.size(), 0);
+    dirty.resize(nodes.size(), true);
+    pending.reserve(nodes.size());
+    for (Index i = 0; i < nodes.size(); ++i) {
+        pending.push_back(i);
+        if (nodes[i].opcode == FlatTree::Opcode::Variable) {
+            auto slot = static_cast<std::size_t>(nodes[i].payload);
+            if (slot >= readers.size())
+                readers.resize(slot + 1);
+            readers[slot].push_back(i);
+        }
+    }
+}
+
+// mark a node and the path to the root dirty
+void IncrementalEvaluator::markDirty(Index index)
+{
+    // a dirty node's ancestors are already dirty
+    for (; index != FlatTree::npos && !dirty[index]; index = nodes[index].parent) {
+        dirty[index] = true;
+        pending.push_back(index);
+    }
+}
+
+// mark everything reading a variable dirty
+void IncrementalEvaluator::invalidate(int slot)
+{
+    if (slot < 0 || static_cast<std::size_t>(slot) >= readers.size())
+        return;
+    for (auto leaf : readers[slot])
+        markDirty(leaf);
+}
+
+// Recompute the dirty nodes.  Children always come before their
+// parents, so recomputing in index order sees up to date children.
+bool IncrementalEvaluator::evaluate(const VariableMap& variables, int& result)
+{
+    std::sort(pending.begin(), pending.end());
+    lastRecomputed = 0;
+
+    // nodes before done have been recomputed; the rest stay pending if
+    // anything goes wrong
+    std::size_t done = 0;
+    auto keepRemaining = [this, &done]() {
+        pending.erase(pending.begin(), pending.begin() + done);
+    };
+
+    try {
+        for (; done < pending.size(); ++done) {
+            auto index = pending[done];
+            const auto& node = nodes[index];
+            int left = node.left == FlatTree::npos ? 0 : values[node.left];
+            int right = node.right == FlatTree::npos ? 0 : values[node.right];
+            int value = 0;
+
+            switch (node.opcode) {
+            case FlatTree::Opcode::Number:
+                value = node.payload;
+                break;
+            case FlatTree::Opcode::Variable:
+                value = variables.get(node.payload);
+                break;
+            case FlatTree::Opcode::Negate:
+                value = -right;
+                break;
+            case FlatTree::Opcode::Add:
+                value = left + right;
+                break;
+            case FlatTree::Opcode::Subtract:
+                value = left - right;
+                break;
+            case FlatTree::Opcode::Multiply:
+                value = left * right;
+                break;
+            case FlatTree::Opcode::Divide:
+                if (right == 0) {
+                    keepRemaining();
+                    return false;
+                }
+                value = left / right;
+                break;
+            case FlatTree::Opcode::Exponent:
+                value = static_cast<int>(pow(left, right));
+                break;
+            case FlatTree::Opcode::Modulus:
+                if (right == 0)
+                    throw std::invalid_argument("Cannot modulus by 0");
+                value = left % right;
+                break;
+            case FlatTree::Opcode::Factorial:
+                if (right > 12)
+                    throw std::invalid_argument("Factorials above 12 are not supported");
+                value = static_cast<int>(tgamma(right + 1));
+                break;
+            case FlatTree::Opcode::Ceiling:
+                value = std::max(left, right);
+                break;
+            case FlatTree::Opcode::Floor:
+                value = std::min(left, right);
+                break;
+            }
+
+            values[index] = value;
+            dirty[index] = false;
+            ++lastRecomputed;
+        }
+    } catch (...) {
+        keepRemaining();
+        throw;
+    }
+
+    pending.clear();
+    result = values.empty() ? 0 : values.back();
+    return true;
+}
+
+// return the number of nodes recomputed
+std::size_t IncrementalEvaluator::recomputed() const
+{
+    return lastRecomputed;
+}
@@ -0,0 +1,107 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "tree/parallel_evaluator.h"
+#include "core/work_stealing_pool.h"
+
+// Ctor
+ParallelEvaluator::ParallelEvaluator(
+    const VariantTree& tree, WorkStealingPool& pool, std::size_t cutoff)
+    : tree(tree)
+    , pool(pool)
+    , cutoff(cutoff)
+    , sizes(tree.size(), 1)
+{
+    // children come before their parents
+    for (Index i = 0; i < sizes.size(); ++i) {
+        auto [left, right] = tree.children(i);
+        if (left != VariantTree::npos)
+            sizes[i] += sizes[left];
+        if (right != VariantTree::npos)
+            sizes[i] += sizes[right];
+    }
+}
+
+// evaluate the whole tree, starting again sequentially if it fails
+bool ParallelEvaluator::evaluate(const VariableMap& variables, int& result) const
+{
+    if (sizes.empty()) {
+        result = 0;
+        return true;
+    }
+
+    std::vector<int> values(sizes.size());
+    std::atomic<bool> failed(false);
+    try {
+        evaluate(static_cast<Index>(sizes.size() - 1), variables, values, failed);
+    } catch (...) {
+        failed = true;
+    }
+
+    if (failed)
+        return tree.evaluate(variables, result);
+    result = values.back();
+    return true;
+}
+
+// Evaluate a subtree.  Nodes with only one child above the cutoff
+// have nothing worth running in parallel, so they are walked down in a
+// loop (evaluating the small child as we go) rather than recursively,
+// which keeps long chains from using up the stack.  At the first node
+// with two big children the left one is forked, the right one is
+// evaluated here, and the two are joined.
+void ParallelEvaluator::evaluate(Index index, const VariableMap& variables,
+    std::vector<int>& values, std::atomic<bool>& failed) const
+{
+    // evaluate the subtree rooted at a node sequentially
+    auto sequential = [&](Index root) {
+        if (!failed && !tree.evaluate(root + 1 - sizes[root], root, variables, values))
+            failed = true;
+    };
+
+    std::vector<Index> spine;
+    while (sizes[index] > cutoff) {
+        auto [left, right] = tree.children(index);
+        if (left != VariantTree::npos && sizes[left] > cutoff && sizes[right] > cutoff)
+            break;
+        spine.push_back(index);
+        if (left == VariantTree::npos)
+            index = right;
+        else if (sizes[left] > cutoff) {
+            sequential(right);
+            index = left;
+        } else {
+            sequential(left);
+            index = right;
+        }
+    }
+    if (failed)
+        return;
+
+    if (sizes[index] <= cutoff)
+        sequential(index);
+    else {
+        auto [left, right] = tree.children(index);
+        WorkStealingPool::Task task(
+            [&, left = left]() { evaluate(left, variables, values, failed); });
+        pool.fork(task);
+        try {
+            evaluate(right, variables, values, failed);
+        } catch (...) {
+            // the task refers to this frame, so it must finish first
+            failed = true;
+            try {
+                pool.join(task);
+            } catch (...) {
+            }
+            throw;
+        }
+        pool.join(task);
+
+        if (!failed && !tree.evaluate(index, index, variables, values))
+            failed = true;
+    }
+
+    // finish the nodes above, nearest first
+    for (auto node = spine.rbegin(); node != spine.rend() && !failed; ++node)
+        if (!tree.evaluate(*node, *node, variables, values))
+            failed = true;
+}
@@ -0,0 +1,412 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "tree/tree_archive.h"
+#include "interpreter/variable_map.h"
+#include "tree/expression_tree_iterator.h"
+#include "tree/leaf_node.h"
+#include "tree/variable_node.h"
+#include "visitors/visitor.h"
+#include <algorithm>
+#include <cmath>
+#include <fcntl.h>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <ostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Magic number and format version at the start of every archive.
+static constexpr std::string_view magic = "ETA1";
+
+// append an unsigned LEB128 varint
+static void putVarint(std::string& out, std::uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+// append a length-prefixed string
+static void putString(std::string& out, std::string_view text)
+{
+    putVarint(out, text.size());
+    out.append(text);
+}
+
+// read an unsigned LEB128 varint, advancing at
+static std::uint64_t getVarint(const std::uint8_t*& at, const std::uint8_t* end)
+{
+    std::uint64_t value = 0;
+    for (int shift = 0; at != end && shift < 64; shift += 7) {
+        auto byte = *at++;
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+    throw TreeArchive::InvalidArchive("Truncated number in expression archive");
+}
+
+// read a length-prefixed string, advancing at
+static std::string_view getString(const std::uint8_t*& at, const std::uint8_t* end)
+{
+    auto size = getVarint(at, end);
+    if (size > static_cast<std::uint64_t>(end - at))
+        throw TreeArchive::InvalidArchive("Truncated string in expression archive");
+    std::string_view text(reinterpret_cast<const char*>(at), size);
+    at += size;
+    return text;
+}
+
+// Walk the pre-order code of a tree, combining the values of its nodes
+// bottom up.  Operators waiting for operands are kept on an explicit
+// stack, so even very deep trees don't use much of the call stack.
+// leaf(opcode, payload) returns the value of a Number or Variable, and
+// combine(opcode, left, right) the value of an operator (ignoring left
+// for unary ones).
+template <typename Value, typename Leaf, typename Combine>
+static Value decode(const std::uint8_t* at, const std::uint8_t* end, Leaf leaf, Combine combine)
+{
+    using Opcode = FlatTree::Opcode;
+
+    struct Pending {
+        Opcode opcode;
+        bool unary;
+        bool hasLeft;
+        Value left;
+    };
+    std::vector<Pending> pending;
+
+    while (at != end) {
+        auto opcode = static_cast<Opcode>(*at++);
+        Value value;
+        switch (opcode) {
+        case Opcode::Number: {
+            // undo the zigzag encoding
+            auto bits = getVarint(at, end);
+            value = leaf(opcode, static_cast<int>((bits >> 1) ^ (~(bits & 1) + 1)));
+            break;
+        }
+        case Opcode::Variable:
+            value = leaf(opcode, static_cast<int>(getVarint(at, end)));
+            break;
+        case Opcode::Negate:
+        case Opcode::Factorial:
+            pending.push_back({ opcode, true, false, Value() });
+            continue;
+        case Opcode::Add:
+        case Opcode::Subtract:
+        case Opcode::Multiply:
+        case Opcode::Divide:
+        case Opcode::Exponent:
+        case Opcode::Modulus:
+        case Opcode::Ceiling:
+        case Opcode::Floor:
+            pending.push_back({ opcode, false, false, Value() });
+            continue;
+        default:
+            throw TreeArchive::InvalidArchive("Unknown node in expression archive");
+        }
+
+        // a complete value finishes every operator it's the last operand of
+        while (true) {
+            if (pending.empty()) {
+                if (at != end)
+                    throw TreeArchive::InvalidArchive("Extra nodes in expression archive");
+                return value;
+            }
+            auto& top = pending.back();
+            if (!top.unary && !top.hasLeft) {
+                top.left = value;
+                top.hasLeft = true;
+                break;
+            }
+            value = combine(top.opcode, top.left, value);
+            pending.pop_back();
+        }
+    }
+    throw TreeArchive::InvalidArchive("Truncated tree in expression archive");
+}
+
+/**
+ * @class Encoder
+ * @brief This plays the role of a visitor that encodes the nodes of an
+ *        expression tree that is being iterated in pre-order fashion.
+ */
+class TreeWriter::Encoder : public Visitor {
+public:
+    Encoder(TreeWriter& writer, std::string& code)
+        : writer(writer)
+        , code(code)
+    {
+    }
+
+    void visit(const LeafNode& node) override
+    {
+        int value = node.item();
+        opcode(FlatTree::Opcode::Number);
+        // zigzag: 0, -1, 1, -2, ... become 0, 1, 2, 3, ...
+        auto bits = static_cast<std::uint64_t>(static_cast<std::int64_t>(value)) << 1;
+        putVarint(code, value < 0 ? ~bits : bits);
+    }
+    void visit(const VariableNode& node) override
+    {
+        opcode(FlatTree::Opcode::Variable);
+        putVarint(code, writer.name(node.item()));
+    }
+    void visit(const NegateNode&) override { opcode(FlatTree::Opcode::Negate); }
+    void visit(const AddNode&) override { opcode(FlatTree::Opcode::Add); }
+    void visit(const SubtractNode&) override { opcode(FlatTree::Opcode::Subtract); }
+    void visit(const DivideNode&) override { opcode(FlatTree::Opcode::Divide); }
+    void visit(const MultiplyNode&) override { opcode(FlatTree::Opcode::Multiply); }
+    void visit(const ExponentNode&) override { opcode(FlatTree::Opcode::Exponent); }
+    void visit(const ModulusNode&) override { opcode(FlatTree::Opcode::Modulus); }
+    void visit(const FactorialNode&) override { opcode(FlatTree::Opcode::Factorial); }
+    void visit(const CeilingNode&) override { opcode(FlatTree::Opcode::Ceiling); }
+    void visit(const FloorNode&) override { opcode(FlatTree::Opcode::Floor); }
+
+private:
+    void opcode(FlatTree::Opcode opcode) { code.push_back(static_cast<char>(opcode)); }
+
+    TreeWriter& writer;
+    std::string& code;
+};
+
+TreeWriter::TreeWriter(const VariableMap& variables)
+    : variables(variables)
+{
+}
+
+void TreeWriter::add(const ExpressionTree& tree, std::string_view key)
+{
+    std::string code;
+    Encoder encoder(*this, code);
+    std::for_each(tree.begin("pre-order"), tree.end("pre-order"),
+        [&encoder](auto node) { node.accept(encoder); });
+    trees.emplace_back(key, std::move(code));
+}
+
+std::size_t TreeWriter::size() const
+{
+    return trees.size();
+}
+
+// return the index in the name table of the variable in a slot, adding
+// it the first time it's seen
+std::uint32_t TreeWriter::name(int slot)
+{
+    auto [iter, added] = nameIndex.try_emplace(slot, static_cast<std::uint32_t>(names.size()));
+    if (added)
+        names.push_back(variables.name(slot));
+    return iter->second;
+}
+
+void TreeWriter::write(std::ostream& os) const
+{
+    std::string header(magic);
+    putVarint(header, names.size());
+    for (const auto& name : names)
+        putString(header, name);
+    putVarint(header, trees.size());
+    os.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+    std::string entry;
+    for (const auto& [key, code] : trees) {
+        entry.clear();
+        putString(entry, key);
+        putString(entry, code);
+        os.write(entry.data(), static_cast<std::streamsize>(entry.size()));
+    }
+}
+
+TreeArchive::TreeArchive(const std::string& path, VariableMap& variables)
+    : data(nullptr)
+    , length(0)
+    , mapped(false)
+{
+    int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+        throw std::runtime_error("Can't open " + path);
+    struct stat status {};
+    if (fstat(file, &status) < 0) {
+        close(file);
+        throw std::runtime_error("Can't read " + path);
+    }
+
+    length = static_cast<std::size_t>(status.st_size);
+    if (length > 0) {
+        void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0);
+        if (address == MAP_FAILED) {
+            close(file);
+            throw std::runtime_error("Can't map " + path);
+        }
+        data = static_cast<const std::uint8_t*>(address);
+        mapped = true;
+    }
+    // the mapping stays valid without the descriptor
+    close(file);
+
+    try {
+        open(variables);
+    } catch (...) {
+        if (mapped)
+            munmap(const_cast<std::uint8_t*>(data), length);
+        throw;
+    }
+}
+
+TreeArchive::TreeArchive(std::istream& is, VariableMap& variables)
+    : data(nullptr)
+    , length(0)
+    , mapped(false)
+    , contents(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>())
+{
+    data = reinterpret_cast<const std::uint8_t*>(contents.data());
+    length = contents.size();
+    open(variables);
+}
+
+TreeArchive::~TreeArchive()
+{
+    if (mapped)
+        munmap(const_cast<std::uint8_t*>(data), length);
+}
+
+// check the magic number, intern the names and find every tree; none
+// of the trees is decoded yet
+void TreeArchive::open(VariableMap& variables)
+{
+    const std::uint8_t* at = data;
+    const std::uint8_t* end = data + length;
+    if (length < magic.size()
+        || std::string_view(reinterpret_cast<const char*>(at), magic.size()) != magic)
+        throw InvalidArchive("Not an expression archive");
+    at += magic.size();
+
+    auto count = getVarint(at, end);
+    // every entry takes at least a byte, which bounds the reservations
+    if (count > length)
+        throw InvalidArchive("Truncated expression archive");
+    names.reserve(count);
+    slots.reserve(count);
+    while (count-- > 0) {
+        names.emplace_back(getString(at, end));
+        slots.push_back(variables.slot(names.back()));
+    }
+
+    count = getVarint(at, end);
+    if (count > length)
+        throw InvalidArchive("Truncated expression archive");
+    entries.reserve(count);
+    keys.reserve(count);
+    while (count-- > 0) {
+        auto key = getString(at, end);
+        auto code = getString(at, end);
+        auto first = reinterpret_cast<const std::uint8_t*>(code.data());
+        entries.push_back({ key, first, first + code.size() });
+        // the first tree with a key wins
+        keys.try_emplace(key, entries.size() - 1);
+    }
+}
+
+std::size_t TreeArchive::size() const
+{
+    return entries.size();
+}
+
+std::string_view TreeArchive::key(std::size_t tree) const
+{
+    return entries.at(tree).key;
+}
+
+bool TreeArchive::find(std::string_view key, std::size_t& tree) const
+{
+    auto iter = keys.find(key);
+    if (iter == keys.end())
+        return false;
+    tree = iter->second;
+    return true;
+}
+
+// The semantics of each operator match those of EvaluationVisitor.
+bool TreeArchive::evaluate(std::size_t tree, const VariableMap& variables, int& result) const
+{
+    using Opcode = FlatTree::Opcode;
+    const auto& entry = entries.at(tree);
+    bool trapped = false;
+
+    auto leaf = [this, &variables](Opcode opcode, int payload) {
+        if (opcode == Opcode::Number)
+            return payload;
+        if (static_cast<std::size_t>(payload) >= slots.size())
+            throw InvalidArchive("Unknown variable in expression archive");
+        return variables.get(slots[payload]);
+    };
+
+    auto combine = [&trapped](Opcode opcode, int left, int right) {
+        switch (opcode) {
+        case Opcode::Negate:
+            return -right;
+        case Opcode::Add:
+            return left + right;
+        case Opcode::Subtract:
+            return left - right;
+        case Opcode::Multiply:
+            return left * right;
+        case Opcode::Divide:
+            if (right == 0) {
+                trapped = true;
+                return 0;
+            }
+            return left / right;
+        case Opcode::Exponent:
+            return static_cast<int>(pow(left, right));
+        case Opcode::Modulus:
+            if (right == 0)
+                throw std::invalid_argument("Cannot modulus by 0");
+            return left % right;
+        case Opcode::Factorial:
+            if (right > 12)
+                throw std::invalid_argument("Factorials above 12 are not supported");
+            return static_cast<int>(tgamma(right + 1));
+        case Opcode::Ceiling:
+            return std::max(left, right);
+        case Opcode::Floor:
+            return std::min(left, right);
+        default:
+            return 0;
+        }
+    };
+
+    int value = decode<int>(entry.code, entry.end, leaf, combine);
+    if (trapped)
+        return false;
+    result = value;
+    return true;
+}
+
+ExpressionTree TreeArchive::tree(std::size_t tree, bool share) const
+{
+    using Opcode = FlatTree::Opcode;
+    const auto& entry = entries.at(tree);
+    auto flat = std::make_unique<FlatTree>(share);
+
+    auto leaf = [this, &flat](Opcode opcode, int payload) {
+        if (opcode == Opcode::Number)
+            return flat->makeLeaf(payload);
+        if (static_cast<std::size_t>(payload) >= slots.size())
+            throw InvalidArchive("Unknown variable in expression archive");
+        return flat->makeVariable(names[payload], slots[payload]);
+    };
+
+    auto combine = [&flat](Opcode opcode, FlatTree::Index left, FlatTree::Index right) {
+        if (opcode == Opcode::Negate || opcode == Opcode::Factorial)
+            return flat->makeUnary(opcode, right);
+        return flat->makeBinary(opcode, left, right);
+    };
+
+    decode<FlatTree::Index>(entry.code, entry.end, leaf, combine);
+    return ExpressionTree(flat.release());
+}
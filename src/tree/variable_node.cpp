@@ -0,0 +1,29 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "tree/variable_node.h"
+#include "visitors/visitor.h"
+
+// Ctor
+VariableNode::VariableNode(std::string name, int slot)
+    : ComponentNode()
+    , variable(std::move(name))
+    , slot(slot)
+{
+}
+
+// return the slot
+int VariableNode::item() const
+{
+    return slot;
+}
+
+// return the name
+const std::string& VariableNode::name() const
+{
+    return variable;
+}
+
+// accept a visitor
+void VariableNode::accept(Visitor& visitor) const
+{
+    visitor.visit(*this);
+}
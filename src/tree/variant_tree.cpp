@@ -0,0 +1,268 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "tree/variant_tree.h"
+#include "interpreter/variable_map.h"
+#include "tree/expression_tree.h"
+#include "tree/expression_tree_iterator.h"
+#include "tree/leaf_node.h"
+#include "tree/variable_node.h"
+#include "visitors/visitor.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+// Combines a set of lambdas into one overloaded function object for
+// std::visit.
+template <typename... Lambdas> struct Overloaded : Lambdas... {
+    using Lambdas::operator()...;
+};
+template <typename... Lambdas> Overloaded(Lambdas...) -> Overloaded<Lambdas...>;
+
+/**
+ * @class Recorder
+ * @brief This plays the role of a visitor that converts the nodes of an
+ *        expression tree that is being iterated in post-order fashion.
+ */
+class VariantTree::Recorder : public Visitor {
+public:
+    Recorder(std::vector<Node>& nodes, std::vector<std::string>& names)
+        : nodes(nodes)
+        , names(names)
+    {
+    }
+
+    void visit(const LeafNode& node) override
+    {
+        push(Number { node.item() });
+    }
+
+    void visit(const VariableNode& node) override
+    {
+        auto slot = static_cast<std::size_t>(node.item());
+        if (slot >= names.size())
+            names.resize(slot + 1);
+        names[slot] = node.name();
+        push(Variable { node.item() });
+    }
+
+    void visit(const NegateNode&) override { push(Negate { pop() }); }
+    void visit(const FactorialNode&) override { push(Factorial { pop() }); }
+    void visit(const AddNode&) override { push(Add { operands() }); }
+    void visit(const SubtractNode&) override { push(Subtract { operands() }); }
+    void visit(const MultiplyNode&) override { push(Multiply { operands() }); }
+    void visit(const DivideNode&) override { push(Divide { operands() }); }
+    void visit(const ExponentNode&) override { push(Exponent { operands() }); }
+    void visit(const ModulusNode&) override { push(Modulus { operands() }); }
+    void visit(const CeilingNode&) override { push(Ceiling { operands() }); }
+    void visit(const FloorNode&) override { push(Floor { operands() }); }
+
+private:
+    void push(const Node& node)
+    {
+        stack.push_back(static_cast<Index>(nodes.size()));
+        nodes.push_back(node);
+    }
+
+    Index pop()
+    {
+        if (stack.empty())
+            throw std::invalid_argument("Required operands not given");
+        auto index = stack.back();
+        stack.pop_back();
+        return index;
+    }
+
+    Operands operands()
+    {
+        auto right = pop();
+        auto left = pop();
+        return { left, right };
+    }
+
+    std::vector<Node>& nodes;
+    std::vector<std::string>& names;
+    // Nodes that still need a parent.
+    std::vector<Index> stack;
+};
+
+// Ctor
+VariantTree::VariantTree(const ExpressionTree& tree)
+{
+    if (!tree.isNull()) {
+        Recorder recorder(nodes, names);
+        std::for_each(tree.begin("post-order"), tree.end("post-order"),
+            [&recorder](auto node) { node.accept(recorder); });
+    }
+}
+
+// return the number of nodes
+std::size_t VariantTree::size() const
+{
+    return nodes.size();
+}
+
+// evaluate every node
+bool VariantTree::evaluate(const VariableMap& variables, int& result) const
+{
+    std::vector<int> values(nodes.size());
+    if (!nodes.empty() && !evaluate(0, static_cast<Index>(nodes.size() - 1), variables, values))
+        return false;
+
+    result = values.empty() ? 0 : values.back();
+    return true;
+}
+
+// Evaluate a range of nodes in post-order, so each node's operands are
+// already in values when it is reached.
+bool VariantTree::evaluate(
+    Index first, Index last, const VariableMap& variables, std::vector<int>& values) const
+{
+    bool trapped = false;
+
+    auto kernel = Overloaded {
+        [](const Number& node) { return node.value; },
+        [&variables](const Variable& node) { return variables.get(node.slot); },
+        [&values](const Negate& node) { return -values[node.right]; },
+        [&values](const Factorial& node) {
+            auto value = values[node.right];
+            if (value > 12)
+                throw std::invalid_argument("Factorials above 12 are not supported");
+            return static_cast<int>(tgamma(value + 1));
+        },
+        [&values](const Add& node) { return values[node.left] + values[node.right]; },
+        [&values](const Subtract& node) { return values[node.left] - values[node.right]; },
+        [&values](const Multiply& node) { return values[node.left] * values[node.right]; },
+        [&values, &trapped](const Divide& node) {
+            if (values[node.right] == 0) {
+                trapped = true;
+                return 0;
+            }
+            return values[node.left] / values[node.right];
+        },
+        [&values](const Exponent& node) {
+            return static_cast<int>(pow(values[node.left], values[node.right]));
+        },
+        [&values](const Modulus& node) {
+            if (values[node.right] == 0)
+                throw std::invalid_argument("Cannot modulus by 0");
+            return values[node.left] % values[node.right];
+        },
+        [&values](const Ceiling& node) {
+            return std::max(values[node.left], values[node.right]);
+        },
+        [&values](const Floor& node) { return std::min(values[node.left], values[node.right]); },
+    };
+
+    for (auto i = first; i <= last; ++i) {
+        values[i] = std::visit(kernel, nodes[i]);
+        if (trapped)
+            return false;
+    }
+    return true;
+}
+
+// print a single node the way PrintVisitor does
+void VariantTree::print(Index index, OutputSink& os) const
+{
+    std::visit(Overloaded {
+                   [&os](const Number& node) { os << node.value << " "; },
+                   [this, &os](const Variable& node) { os << names[node.slot] << " "; },
+                   [&os](const Negate&) { os << '-'; },
+                   [&os](const Factorial&) { os << "! "; },
+                   [&os](const Add&) { os << "+ "; },
+                   [&os](const Subtract&) { os << "- "; },
+                   [&os](const Multiply&) { os << "* "; },
+                   [&os](const Divide&) { os << "/ "; },
+                   [&os](const Exponent&) { os << "^ "; },
+                   [&os](const Modulus&) { os << "% "; },
+                   [&os](const Ceiling&) { os << "| "; },
+                   [&os](const Floor&) { os << "_ "; },
+               },
+        nodes[index]);
+}
+
+// return the children of a node
+VariantTree::Operands VariantTree::children(Index index) const
+{
+    return std::visit(Overloaded {
+                          [](const Number&) { return Operands { npos, npos }; },
+                          [](const Variable&) { return Operands { npos, npos }; },
+                          [](const Negate& node) { return Operands { npos, node.right }; },
+                          [](const Factorial& node) { return Operands { npos, node.right }; },
+                          [](const Operands& node) { return node; },
+                      },
+        nodes[index]);
+}
+
+// print in order with an explicit stack, since a chain of operators
+// can be too deep to recurse over
+void VariantTree::printInOrder(Index index, OutputSink& os) const
+{
+    // each node is pushed once to expand its children and once more,
+    // between them, to be printed
+    std::vector<std::pair<Index, bool>> stack { { index, false } };
+    while (!stack.empty()) {
+        auto [top, expanded] = stack.back();
+        stack.pop_back();
+        if (expanded) {
+            print(top, os);
+            continue;
+        }
+        auto [left, right] = children(top);
+        if (right != npos)
+            stack.emplace_back(right, false);
+        stack.emplace_back(top, true);
+        if (left != npos)
+            stack.emplace_back(left, false);
+    }
+}
+
+// print in pre-order with an explicit stack
+void VariantTree::printPreOrder(Index index, OutputSink& os) const
+{
+    std::vector<Index> stack { index };
+    while (!stack.empty()) {
+        auto top = stack.back();
+        stack.pop_back();
+        print(top, os);
+        auto [left, right] = children(top);
+        if (right != npos)
+            stack.push_back(right);
+        if (left != npos)
+            stack.push_back(left);
+    }
+}
+
+// print the tree in the designated order
+void VariantTree::print(const std::string& order, OutputSink& os) const
+{
+    if (order != "in-order" && order != "pre-order" && order != "post-order"
+        && order != "level-order")
+        throw ExpressionTree::InvalidIterator(order);
+    if (nodes.empty())
+        return;
+
+    Index root = static_cast<Index>(nodes.size() - 1);
+    if (order == "in-order")
+        printInOrder(root, os);
+    else if (order == "pre-order")
+        printPreOrder(root, os);
+    else if (order == "post-order")
+        for (Index i = 0; i <= root; ++i)
+            print(i, os);
+    else {
+        std::queue<Index> queue;
+        queue.push(root);
+        while (!queue.empty()) {
+            auto index = queue.front();
+            queue.pop();
+            print(index, os);
+            auto [left, right] = children(index);
+            if (left != npos)
+                queue.push(left);
+            if (right != npos)
+                queue.push(right);
+        }
+    }
+}
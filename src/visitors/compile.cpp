@@ -0,0 +1,74 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "visitors/compile.h"
+#include "tree/leaf_node.h"
+#include "tree/variable_node.h"
+
+// leaves push their value
+void CompileVisitor::visit(const LeafNode& node)
+{
+    bytecode.emit(Bytecode::Opcode::PushConst, node.item());
+}
+
+// variables push the value in their slot
+void CompileVisitor::visit(const VariableNode& node)
+{
+    bytecode.emit(Bytecode::Opcode::PushVar, node.item());
+}
+
+// every operator emits its matching instruction; its operands have
+// already been emitted by the post-order traversal
+void CompileVisitor::visit(const NegateNode&)
+{
+    bytecode.emit(Bytecode::Opcode::Negate);
+}
+
+void CompileVisitor::visit(const AddNode&)
+{
+    bytecode.emit(Bytecode::Opcode::Add);
+}
+
+void CompileVisitor::visit(const SubtractNode&)
+{
+    bytecode.emit(Bytecode::Opcode::Subtract);
+}
+
+void CompileVisitor::visit(const DivideNode&)
+{
+    bytecode.emit(Bytecode::Opcode::Divide);
+}
+
+void CompileVisitor::visit(const MultiplyNode&)
+{
+    bytecode.emit(Bytecode::Opcode::Multiply);
+}
+
+void CompileVisitor::visit(const ExponentNode&)
+{
+    bytecode.emit(Bytecode::Opcode::Exponent);
+}
+
+void CompileVisitor::visit(const ModulusNode&)
+{
+    bytecode.emit(Bytecode::Opcode::Modulus);
+}
+
+void CompileVisitor::visit(const FactorialNode&)
+{
+    bytecode.emit(Bytecode::Opcode::Factorial);
+}
+
+void CompileVisitor::visit(const CeilingNode&)
+{
+    bytecode.emit(Bytecode::Opcode::Ceiling);
+}
+
+void CompileVisitor::visit(const FloorNode&)
+{
+    bytecode.emit(Bytecode::Opcode::Floor);
+}
+
+// return the compiled program
+const Bytecode& CompileVisitor::program() const
+{
+    return bytecode;
+}
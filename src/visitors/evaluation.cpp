@@ -1,15 +1,37 @@
 /* Copyright G. Hemingway @ 2022, All Rights Reserved */
 #include "visitors/evaluation.h"
+#include "interpreter/variable_map.h"
 #include "tree/leaf_node.h"
+#include "tree/variable_node.h"
 #include <cmath>
 #include <iostream>
 
+// Ctor
+EvaluationVisitor::EvaluationVisitor()
+    : variables(nullptr)
+{
+}
+
+// Ctor
+EvaluationVisitor::EvaluationVisitor(const VariableMap& variables)
+    : variables(&variables)
+{
+}
+
 // base evaluation for a node. This is used by LeafNode
 void EvaluationVisitor::visit(const LeafNode& node)
 {
     stack.push(node.item());
 }
 
+// evaluation of a variable looks up its current value
+void EvaluationVisitor::visit(const VariableNode& node)
+{
+    if (!variables)
+        throw std::logic_error("Unknown variable");
+    stack.push(variables->get(node.item()));
+}
+
 // evaluation of a negation (NegateNode)
 void EvaluationVisitor::visit(const NegateNode&)
 {
@@ -1,6 +1,7 @@
 /* Copyright G. Hemingway @ 2022, All Rights Reserved */
 #include "visitors/print.h"
 #include "tree/leaf_node.h"
+#include "tree/variable_node.h"
 
 // visit function - prints LeafNode contents to output stream
 void PrintVisitor::visit(const LeafNode& node)
@@ -8,6 +9,12 @@ void PrintVisitor::visit(const LeafNode& node)
     os << node.item() << " ";
 }
 
+// visit function - prints VariableNode name to output stream
+void PrintVisitor::visit(const VariableNode& node)
+{
+    os << node.name() << " ";
+}
+
 // visit function - prints CompositeNegateNode contents to is
 void PrintVisitor::visit(const NegateNode&)
 {
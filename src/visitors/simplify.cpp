@@ -0,0 +1,278 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "visitors/simplify.h"
+#include "tree/leaf_node.h"
+#include "tree/variable_node.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <memory>
+
+// Integer arithmetic wraps around the same way evaluation does, without
+// the undefined behavior of signed overflow at compile time.
+static int wrap(long long value)
+{
+    return static_cast<int>(static_cast<unsigned int>(value));
+}
+
+// Copy the subtree rooted at index in one tree into another, returning
+// its new index.
+static FlatTree::Index copy(const FlatTree& from, FlatTree::Index index, FlatTree& to)
+{
+    const auto& node = from.node(index);
+
+    switch (node.opcode) {
+    case FlatTree::Opcode::Number:
+        return to.makeLeaf(node.payload);
+    case FlatTree::Opcode::Variable:
+        return to.makeVariable(from.name(node.payload), node.payload);
+    case FlatTree::Opcode::Negate:
+    case FlatTree::Opcode::Factorial:
+        return to.makeUnary(node.opcode, copy(from, node.right, to));
+    default: {
+        auto left = copy(from, node.left, to);
+        auto right = copy(from, node.right, to);
+        return to.makeBinary(node.opcode, left, right);
+    }
+    }
+}
+
+// Ctor
+SimplifyVisitor::SimplifyVisitor()
+    : scratch()
+    , stack()
+    , count(0)
+{
+}
+
+// push a literal
+void SimplifyVisitor::constant(int value)
+{
+    stack.push_back({ scratch.makeLeaf(value), true, value, false, 1 });
+}
+
+// simplify a unary operator
+void SimplifyVisitor::unary(FlatTree::Opcode opcode)
+{
+    auto child = stack.back();
+    stack.pop_back();
+
+    if (opcode == FlatTree::Opcode::Negate) {
+        if (child.constant)
+            return constant(wrap(-static_cast<long long>(child.value)));
+
+        // --x = x
+        const auto& node = scratch.node(child.index);
+        if (node.opcode == FlatTree::Opcode::Negate) {
+            stack.push_back({ node.right, false, 0, child.canTrap, child.size - 1 });
+            return;
+        }
+    } else if (child.constant && child.value >= 0 && child.value <= 12) {
+        // the same computation as evaluation, which rejects anything else
+        return constant(static_cast<int>(tgamma(child.value + 1)));
+    }
+
+    bool canTrap = child.canTrap || opcode == FlatTree::Opcode::Factorial;
+    stack.push_back(
+        { scratch.makeUnary(opcode, child.index), false, 0, canTrap, child.size + 1 });
+}
+
+// simplify a binary operator
+void SimplifyVisitor::binary(FlatTree::Opcode opcode)
+{
+    auto right = stack.back();
+    stack.pop_back();
+    auto left = stack.back();
+    stack.pop_back();
+
+    auto is = [](const Value& value, int literal) {
+        return value.constant && value.value == literal;
+    };
+
+    if (left.constant && right.constant) {
+        long long l = left.value;
+        long long r = right.value;
+        switch (opcode) {
+        case FlatTree::Opcode::Add:
+            return constant(wrap(l + r));
+        case FlatTree::Opcode::Subtract:
+            return constant(wrap(l - r));
+        case FlatTree::Opcode::Multiply:
+            return constant(wrap(l * r));
+        case FlatTree::Opcode::Exponent:
+            return constant(static_cast<int>(pow(left.value, right.value)));
+        case FlatTree::Opcode::Ceiling:
+            return constant(std::max(left.value, right.value));
+        case FlatTree::Opcode::Floor:
+            return constant(std::min(left.value, right.value));
+        case FlatTree::Opcode::Divide:
+            if (r != 0 && !(l == INT_MIN && r == -1))
+                return constant(left.value / right.value);
+            break;
+        case FlatTree::Opcode::Modulus:
+            if (r != 0 && !(l == INT_MIN && r == -1))
+                return constant(left.value % right.value);
+            break;
+        default:
+            break;
+        }
+    }
+
+    switch (opcode) {
+    case FlatTree::Opcode::Add:
+        // x+0 = 0+x = x
+        if (is(right, 0)) {
+            stack.push_back(left);
+            return;
+        }
+        if (is(left, 0)) {
+            stack.push_back(right);
+            return;
+        }
+        break;
+    case FlatTree::Opcode::Subtract:
+        // x-0 = x, 0-x = -x
+        if (is(right, 0)) {
+            stack.push_back(left);
+            return;
+        }
+        if (is(left, 0)) {
+            stack.push_back(right);
+            return unary(FlatTree::Opcode::Negate);
+        }
+        break;
+    case FlatTree::Opcode::Multiply:
+        // x*1 = 1*x = x, x*-1 = -1*x = -x, x*0 = 0*x = 0
+        if (is(right, 1)) {
+            stack.push_back(left);
+            return;
+        }
+        if (is(left, 1)) {
+            stack.push_back(right);
+            return;
+        }
+        if (is(right, -1)) {
+            stack.push_back(left);
+            return unary(FlatTree::Opcode::Negate);
+        }
+        if (is(left, -1)) {
+            stack.push_back(right);
+            return unary(FlatTree::Opcode::Negate);
+        }
+        if ((is(right, 0) && !left.canTrap) || (is(left, 0) && !right.canTrap))
+            return constant(0);
+        break;
+    case FlatTree::Opcode::Divide:
+        // x/1 = x
+        if (is(right, 1)) {
+            stack.push_back(left);
+            return;
+        }
+        break;
+    case FlatTree::Opcode::Exponent:
+        // x^1 = x, x^0 = 1^x = 1
+        if (is(right, 1)) {
+            stack.push_back(left);
+            return;
+        }
+        if ((is(right, 0) && !left.canTrap) || (is(left, 1) && !right.canTrap))
+            return constant(1);
+        break;
+    default:
+        break;
+    }
+
+    bool canTrap = left.canTrap || right.canTrap || opcode == FlatTree::Opcode::Divide
+        || opcode == FlatTree::Opcode::Modulus;
+    stack.push_back({ scratch.makeBinary(opcode, left.index, right.index), false, 0, canTrap,
+        left.size + right.size + 1 });
+}
+
+void SimplifyVisitor::visit(const LeafNode& node)
+{
+    ++count;
+    constant(node.item());
+}
+
+void SimplifyVisitor::visit(const VariableNode& node)
+{
+    ++count;
+    stack.push_back({ scratch.makeVariable(node.name(), node.item()), false, 0, false, 1 });
+}
+
+void SimplifyVisitor::visit(const NegateNode&)
+{
+    ++count;
+    unary(FlatTree::Opcode::Negate);
+}
+
+void SimplifyVisitor::visit(const AddNode&)
+{
+    ++count;
+    binary(FlatTree::Opcode::Add);
+}
+
+void SimplifyVisitor::visit(const SubtractNode&)
+{
+    ++count;
+    binary(FlatTree::Opcode::Subtract);
+}
+
+void SimplifyVisitor::visit(const DivideNode&)
+{
+    ++count;
+    binary(FlatTree::Opcode::Divide);
+}
+
+void SimplifyVisitor::visit(const MultiplyNode&)
+{
+    ++count;
+    binary(FlatTree::Opcode::Multiply);
+}
+
+void SimplifyVisitor::visit(const ExponentNode&)
+{
+    ++count;
+    binary(FlatTree::Opcode::Exponent);
+}
+
+void SimplifyVisitor::visit(const ModulusNode&)
+{
+    ++count;
+    binary(FlatTree::Opcode::Modulus);
+}
+
+void SimplifyVisitor::visit(const FactorialNode&)
+{
+    ++count;
+    unary(FlatTree::Opcode::Factorial);
+}
+
+void SimplifyVisitor::visit(const CeilingNode&)
+{
+    ++count;
+    binary(FlatTree::Opcode::Ceiling);
+}
+
+void SimplifyVisitor::visit(const FloorNode&)
+{
+    ++count;
+    binary(FlatTree::Opcode::Floor);
+}
+
+// Copy what is left of the tree out of the scratch space, which leaves
+// behind the nodes that were simplified away.
+ExpressionTree SimplifyVisitor::tree(bool share) const
+{
+    if (stack.empty())
+        return {};
+
+    auto tree = std::make_unique<FlatTree>(share);
+    copy(scratch, stack.back().index, *tree);
+    return ExpressionTree(tree.release());
+}
+
+// return the number of nodes simplified away
+std::size_t SimplifyVisitor::removed() const
+{
+    return stack.empty() ? 0 : count - stack.back().size;
+}
@@ -0,0 +1,286 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "interpreter/interpreter.h"
+#include "interpreter/pratt_parser.h"
+#include "interpreter/variable_map.h"
+#include "output_sink.h"
+#include "tree/bytecode.h"
+#include "tree/expression_tree.h"
+#include "tree/expression_tree_iterator.h"
+#include "tree/incremental_evaluator.h"
+#include "tree/variant_tree.h"
+#include "visitors/evaluation.h"
+#include "visitors/print.h"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const char* const orders[] = { "in-order", "pre-order", "post-order", "level-order" };
+
+// Expressions that repeat subexpressions, so sharing turns them into DAGs.
+const char* const repeated[] = { "1+1*2", "x+x*2", "(a+b)*(a+b)-(a+b)", "-(x*x)+-(x*x)",
+    "x*x*x*x", "(1+2)*(1+2)*(1+2)" };
+
+// Print the tree in the designated order.
+std::string print(const ExpressionTree& tree, const std::string& order)
+{
+    std::ostringstream text;
+    {
+        OutputSink os(text);
+        PrintVisitor visitor(os);
+        std::for_each(
+            tree.begin(order), tree.end(order), [&visitor](auto node) { node.accept(visitor); });
+    }
+    return text.str();
+}
+
+// Print the tree as a VariantTree in the designated order.
+std::string printVariant(const ExpressionTree& tree, const std::string& order)
+{
+    std::ostringstream text;
+    {
+        OutputSink os(text);
+        VariantTree(tree).print(order, os);
+    }
+    return text.str();
+}
+
+// Evaluate the tree by walking it in post-order.
+int evaluate(const ExpressionTree& tree, const VariableMap& variables)
+{
+    EvaluationVisitor visitor(variables);
+    std::for_each(tree.begin("post-order"), tree.end("post-order"),
+        [&visitor](auto node) { node.accept(visitor); });
+    return visitor.total();
+}
+
+} // namespace
+
+TEST(ExpressionTreeTest, SharedNodesArePrintedInEveryOrder)
+{
+    for (auto expression : repeated) {
+        VariableMap variables;
+        auto plain = Interpreter::interpretFlat(variables, expression, false);
+        auto shared = Interpreter::interpretFlat(variables, expression, true);
+        for (auto order : orders)
+            EXPECT_EQ(print(plain, order), print(shared, order)) << expression << ' ' << order;
+    }
+}
+
+TEST(ExpressionTreeTest, SharedNodesAreExpandedInPostOrder)
+{
+    VariableMap variables;
+    auto shared = Interpreter::interpretFlat(variables, "1+1*2", true);
+    auto plain = Interpreter::interpret(variables, "1+1*2");
+    EXPECT_EQ(print(shared, "post-order"), print(plain, "post-order"));
+    EXPECT_EQ(print(shared, "post-order"), "1 1 2 * + ");
+}
+
+TEST(ExpressionTreeTest, SharedNodesEvaluateAndSimplify)
+{
+    for (auto expression : repeated) {
+        VariableMap variables;
+        for (auto name : { "x", "a", "b" })
+            variables.set(name, 3);
+        auto plain = Interpreter::interpretFlat(variables, expression, false);
+        auto shared = Interpreter::interpretFlat(variables, expression, true);
+        EXPECT_EQ(evaluate(plain, variables), evaluate(shared, variables)) << expression;
+
+        std::size_t removed;
+        auto simplified = shared.simplify(removed, true);
+        EXPECT_EQ(evaluate(plain, variables), evaluate(simplified, variables)) << expression;
+    }
+}
+
+TEST(ExpressionTreeTest, SimplifyFoldsAndDropsIdentities)
+{
+    struct Case {
+        const char* expression;
+        const char* simplified;
+        std::size_t removed;
+    };
+    const Case cases[] = {
+        // folding
+        { "2+3", "5 ", 2 },
+        { "2-3", "-1 ", 2 },
+        { "2*3", "6 ", 2 },
+        { "2^3", "8 ", 2 },
+        { "2|3", "3 ", 2 },
+        { "2_3", "2 ", 2 },
+        { "7/2", "3 ", 2 },
+        { "7%2", "1 ", 2 },
+        { "-(2)", "-2 ", 1 },
+        { "3!", "6 ", 1 },
+        { "x+(2*3)", "x + 6 ", 2 },
+        // left for evaluation to reject
+        { "7/0", "7 / 0 ", 0 },
+        { "7%0", "7 % 0 ", 0 },
+        { "13!", "! 13 ", 0 },
+        // identities
+        { "x+0", "x ", 2 },
+        { "0+x", "x ", 2 },
+        { "x-0", "x ", 2 },
+        { "0-x", "-x ", 1 },
+        { "--x", "x ", 2 },
+        { "x*1", "x ", 2 },
+        { "1*x", "x ", 2 },
+        { "x*-1", "-x ", 2 },
+        { "-1*x", "-x ", 2 },
+        { "x*0", "0 ", 2 },
+        { "0*x", "0 ", 2 },
+        { "x/1", "x ", 2 },
+        { "x^1", "x ", 2 },
+        { "x^0", "1 ", 2 },
+        { "1^x", "1 ", 2 },
+        // a subtree that can trap must still be evaluated
+        { "(1/x)*0", "1 / x * 0 ", 0 },
+        { "0*(1/x)", "0 * 1 / x ", 0 },
+        { "(1/x)^0", "1 / x ^ 0 ", 0 },
+        { "1^(1/x)", "1 ^ 1 / x ", 0 },
+        { "x!*0", "! x * 0 ", 0 },
+        { "1^(x%y)", "1 ^ x % y ", 0 },
+    };
+
+    for (const auto& test : cases) {
+        for (bool share : { false, true }) {
+            VariableMap variables;
+            auto tree = PrattParser::parse(variables, test.expression, share);
+            std::size_t removed;
+            auto simplified = tree.simplify(removed, share);
+            EXPECT_EQ(print(simplified, "in-order"), test.simplified) << test.expression;
+            EXPECT_EQ(removed, test.removed) << test.expression;
+        }
+    }
+}
+
+TEST(ExpressionTreeTest, IncrementalEvaluationTracksSets)
+{
+    const char* const expressions[] = { "(x+y)*(x+y)-x*z", "x*x*x-(y|x)_z",
+        "-(x-y)^2+(x-y)*z", "x" };
+    const char* const names[] = { "x", "y", "z" };
+    std::mt19937 random(2022);
+    std::uniform_int_distribution<int> value(-3, 3);
+    std::uniform_int_distribution<int> name(0, 2);
+    std::uniform_int_distribution<int> sets(1, 3);
+
+    for (auto expression : expressions) {
+        for (bool share : { false, true }) {
+            VariableMap variables;
+            for (auto n : names)
+                variables.set(n, value(random));
+            auto tree = Interpreter::interpretFlat(variables, expression, share);
+            IncrementalEvaluator incremental(tree);
+
+            int result;
+            ASSERT_TRUE(incremental.evaluate(variables, result));
+            EXPECT_EQ(result, evaluate(tree, variables)) << expression;
+
+            // nothing changed, so nothing is recomputed
+            ASSERT_TRUE(incremental.evaluate(variables, result));
+            EXPECT_EQ(incremental.recomputed(), 0u) << expression;
+            EXPECT_EQ(result, evaluate(tree, variables)) << expression;
+
+            // several sets between evaluations, often of the same variable
+            // or of variables that share ancestors, so later sets meet
+            // nodes the earlier ones already marked dirty
+            for (int round = 0; round < 50; ++round) {
+                for (int i = sets(random); i > 0; --i) {
+                    auto n = names[name(random)];
+                    variables.set(n, value(random));
+                    incremental.invalidate(variables.find(n));
+                }
+                ASSERT_TRUE(incremental.evaluate(variables, result));
+                EXPECT_EQ(result, evaluate(tree, variables)) << expression << " round " << round;
+            }
+        }
+    }
+}
+
+TEST(ExpressionTreeTest, DeepChainsCompile)
+{
+    // far deeper than the call stack could recurse
+    std::string chain = "1";
+    for (int i = 1; i < 300000; ++i)
+        chain += "+1";
+
+    for (bool share : { false, true }) {
+        VariableMap variables;
+        auto tree = PrattParser::parse(variables, chain, share);
+        int result = 0;
+        ASSERT_TRUE(tree.compile().run(variables, result));
+        EXPECT_EQ(result, 300000);
+    }
+}
+
+TEST(ExpressionTreeTest, VariantTreesPrintLikeVisitors)
+{
+    for (auto expression : repeated) {
+        VariableMap variables;
+        auto tree = Interpreter::interpretFlat(variables, expression, true);
+        for (auto order : orders)
+            EXPECT_EQ(printVariant(tree, order), print(tree, order)) << expression << ' ' << order;
+    }
+}
+
+TEST(ExpressionTreeTest, DeepChainsPrintAsVariants)
+{
+    std::string chain = "1";
+    for (int i = 1; i < 300000; ++i)
+        chain += "+1";
+
+    VariableMap variables;
+    auto tree = PrattParser::parse(variables, chain, false);
+    auto inOrder = printVariant(tree, "in-order");
+    EXPECT_EQ(inOrder.size(), chain.size() * 2);
+    EXPECT_EQ(inOrder.compare(0, 8, "1 + 1 + "), 0);
+    auto preOrder = printVariant(tree, "pre-order");
+    EXPECT_EQ(preOrder.size(), chain.size() * 2);
+    EXPECT_EQ(preOrder.compare(0, 4, "+ + "), 0);
+    EXPECT_EQ(preOrder.compare(preOrder.size() - 4, 4, "1 1 "), 0);
+}
+
+TEST(ExpressionTreeTest, BatchesMatchSingleEvaluations)
+{
+    // enough rows for several blocks, many of which divide by zero
+    const std::size_t rows = 1000;
+    std::mt19937 random(2022);
+    std::uniform_int_distribution<int> value(-3, 3);
+    // x is never 1, where 5%(1/x-1) and (1/x+12)! would throw rather
+    // than just divide by zero when x is 0
+    const int xs[] = { -3, -2, -1, 0, 2, 3 };
+    std::uniform_int_distribution<int> x(0, 5);
+    std::unordered_map<std::string, std::vector<int>> columns;
+    for (std::size_t row = 0; row < rows; ++row) {
+        columns["x"].push_back(xs[x(random)]);
+        columns["y"].push_back(value(random));
+    }
+
+    const char* const expressions[] = { "x/y+z", "(x-y)/(y-z)*2", "x%3+z/(y+1)", "x/y/z",
+        "x*x/(x*x)", "-(x/y)^2|z", "5%(1/x-1)", "(1/x+12)!" };
+    for (auto expression : expressions) {
+        for (bool flat : { false, true }) {
+            VariableMap variables;
+            variables.set("z", 2);
+            auto tree = flat ? Interpreter::interpretFlat(variables, expression, true)
+                             : Interpreter::interpret(variables, expression);
+            auto results = tree.evaluateBatch(variables, columns);
+            ASSERT_EQ(results.size(), rows);
+
+            // evaluate each row the way eval does
+            auto program = tree.compile();
+            for (std::size_t row = 0; row < rows; ++row) {
+                for (const auto& column : columns)
+                    variables.set(column.first, column.second[row]);
+                int expected;
+                if (!program.run(variables, expected))
+                    expected = evaluate(tree, variables);
+                EXPECT_EQ(results[row], expected) << expression << " row " << row;
+            }
+        }
+    }
+}
@@ -0,0 +1,157 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "interpreter/interpreter.h"
+#include "interpreter/pratt_parser.h"
+#include "interpreter/variable_map.h"
+#include "output_sink.h"
+#include "tree/expression_tree.h"
+#include "tree/expression_tree_iterator.h"
+#include "visitors/print.h"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// Print the tree in pre-order, which (with each operator's arity known)
+// spells out its structure unambiguously.
+std::string structure(const ExpressionTree& tree)
+{
+    std::ostringstream text;
+    {
+        OutputSink os(text);
+        PrintVisitor visitor(os);
+        std::for_each(tree.begin("pre-order"), tree.end("pre-order"),
+            [&visitor](auto node) { node.accept(visitor); });
+    }
+    return text.str();
+}
+
+std::string legacy(const std::string& expression)
+{
+    VariableMap variables;
+    return structure(Interpreter::interpret(variables, expression));
+}
+
+std::string pratt(const std::string& expression)
+{
+    VariableMap variables;
+    return structure(PrattParser::parse(variables, expression));
+}
+
+// Generates random expressions over every operator.
+class ExpressionGenerator {
+public:
+    explicit ExpressionGenerator(unsigned seed)
+        : random(seed)
+    {
+    }
+
+    std::string operator()(int depth = 0)
+    {
+        auto choice = pick(depth > 3 ? 2 : 10);
+        if (choice < 2)
+            return pick(2) ? std::to_string(pick(10)) : std::string(1, "xyz"[pick(3)]);
+        if (choice == 2)
+            return "-" + (*this)(depth + 1);
+        if (choice == 3)
+            return "(" + (*this)(depth + 1) + ")";
+        if (choice == 4)
+            return (*this)(depth + 1) + "!";
+
+        char op = "+-*/%^|_"[pick(8)];
+        auto left = (*this)(depth + 1);
+        return left + op + (*this)(depth + 1);
+    }
+
+private:
+    int pick(int n) { return std::uniform_int_distribution<int>(0, n - 1)(random); }
+
+    std::mt19937 random;
+};
+
+// Evaluate the expression with both parsers, which must agree.
+int evaluate(const std::string& expression)
+{
+    VariableMap variables;
+    int legacyResult = 0;
+    int prattResult = 0;
+    EXPECT_TRUE(Interpreter::interpret(variables, expression).compile().run(variables, legacyResult));
+    EXPECT_TRUE(PrattParser::parse(variables, expression).compile().run(variables, prattResult));
+    EXPECT_EQ(legacyResult, prattResult) << expression;
+    return legacyResult;
+}
+
+} // namespace
+
+TEST(ParserTest, PrattMatchesInterpreter)
+{
+    const char* const expressions[] = { "1+2*3", "(1+2)*3", "1-2-3", "8/4/2", "2^3^2", "-2^2",
+        "--2", "3!", "-3!", "(-3)!", "1+2^(-9)", "1^2--3", "2^3!-4", "1*(--2)", "1*--2", "1+2^-9", "((1+2)*3)^2",
+        "(7/8*(3)!)", "x|y_z%2", "(1+2", "(((1)))" };
+    for (auto expression : expressions)
+        EXPECT_EQ(pratt(expression), legacy(expression)) << expression;
+}
+
+TEST(ParserTest, PrattMatchesInterpreterOnRandomExpressions)
+{
+    ExpressionGenerator generate(2022);
+    for (int i = 0; i < 2000; ++i) {
+        auto expression = generate();
+        EXPECT_EQ(pratt(expression), legacy(expression)) << expression;
+    }
+}
+
+TEST(ParserTest, InnerParenthesesCloseOnlyTheirGroup)
+{
+    EXPECT_EQ(evaluate("((1+2)*3)^2"), 81);
+    EXPECT_EQ(evaluate("(7/8*(3)!)"), 0);
+    EXPECT_EQ(evaluate("2*((1+2)+3)"), 12);
+    EXPECT_EQ(evaluate("(((1)+2)*3)-4"), 5);
+}
+
+TEST(ParserTest, NegationsKeepWhatPrecedesThem)
+{
+    EXPECT_EQ(legacy("1+2^-9"), "+ 1 ^ 2 -9 ");
+    EXPECT_EQ(legacy("1*--2"), "* 1 --2 ");
+    EXPECT_EQ(evaluate("1+2^-9"), 1);
+    EXPECT_EQ(evaluate("1*--2"), 2);
+    EXPECT_EQ(evaluate("(3-2-3!)*--4"), -20);
+    EXPECT_EQ(evaluate("3+7^1^-2"), 3);
+    EXPECT_EQ(evaluate("4-3+7^1^-2"), 1);
+    EXPECT_EQ(evaluate("-2^2"), -4);
+    EXPECT_EQ(evaluate("2*-3!"), -12);
+    EXPECT_EQ(evaluate("2^-(1+1)*5"), 0);
+}
+
+TEST(VariableMapTest, CopiesKeepTheirOwnNames)
+{
+    auto original = std::make_unique<VariableMap>();
+    original->set("x", 1);
+    original->set("y", 2);
+    VariableMap copy(*original);
+    VariableMap assigned;
+    assigned.set("z", 3);
+    assigned = *original;
+    original.reset();
+
+    for (auto* variables : { &copy, &assigned }) {
+        EXPECT_EQ(variables->find("x"), 0);
+        EXPECT_EQ(variables->get("y"), 2);
+        EXPECT_EQ(variables->find("z"), -1);
+        variables->set("z", 3);
+        EXPECT_EQ(variables->get("z"), 3);
+    }
+}
+
+TEST(ParserTest, PrattRejectsUnmatchedParentheses)
+{
+    for (auto expression : { "1+2)*3", ")", "(1))", "1)+(2" }) {
+        VariableMap variables;
+        EXPECT_THROW(PrattParser::parse(variables, expression), std::invalid_argument)
+            << expression;
+    }
+}
@@ -0,0 +1,178 @@
+/* Copyright G. Hemingway @ 2022, All Rights Reserved */
+#include "interpreter/interpreter.h"
+#include "interpreter/variable_map.h"
+#include "output_sink.h"
+#include "tree/expression_tree.h"
+#include "tree/expression_tree_iterator.h"
+#include "tree/tree_archive.h"
+#include "visitors/evaluation.h"
+#include "visitors/print.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+const char* const expressions[] = { "1+2*3", "x*y-x", "-(x+1)^2%7", "3!|y_-4", "x/(y-y)",
+    "(a+b)*(a+b)-(a+b)", "-123456789+x" };
+
+// Print the tree in pre-order, which spells out its structure.
+std::string structure(const ExpressionTree& tree)
+{
+    std::ostringstream text;
+    {
+        OutputSink os(text);
+        PrintVisitor visitor(os);
+        std::for_each(tree.begin("pre-order"), tree.end("pre-order"),
+            [&visitor](auto node) { node.accept(visitor); });
+    }
+    return text.str();
+}
+
+// Evaluate the tree by walking it in post-order.
+int evaluate(const ExpressionTree& tree, const VariableMap& variables)
+{
+    EvaluationVisitor visitor(variables);
+    std::for_each(tree.begin("post-order"), tree.end("post-order"),
+        [&visitor](auto node) { node.accept(visitor); });
+    return visitor.total();
+}
+
+void assign(VariableMap& variables)
+{
+    variables.set("x", 5);
+    variables.set("y", -3);
+    variables.set("a", 2);
+    variables.set("b", 7);
+}
+
+// Write every expression to an archive keyed by its text.
+std::string archive()
+{
+    VariableMap variables;
+    TreeWriter writer(variables);
+    for (auto expression : expressions)
+        writer.add(Interpreter::interpretFlat(variables, expression), expression);
+    std::ostringstream os;
+    writer.write(os);
+    return os.str();
+}
+
+// Check that every tree in the archive matches the expression it was
+// written from.
+void expectExpressions(const TreeArchive& archived, VariableMap& variables)
+{
+    assign(variables);
+    ASSERT_EQ(archived.size(), std::size(expressions));
+    for (std::size_t i = 0; i < archived.size(); ++i) {
+        VariableMap parsedVariables;
+        assign(parsedVariables);
+        auto parsed = Interpreter::interpret(parsedVariables, expressions[i]);
+        auto tree = archived.tree(i);
+
+        EXPECT_EQ(archived.key(i), expressions[i]);
+        EXPECT_EQ(structure(tree), structure(parsed)) << expressions[i];
+
+        std::size_t found;
+        EXPECT_TRUE(archived.find(expressions[i], found));
+        EXPECT_EQ(found, i);
+
+        // evaluating straight from the archive traps where the tree
+        // would divide by zero
+        int result = 0;
+        if (archived.evaluate(i, variables, result))
+            EXPECT_EQ(result, evaluate(parsed, parsedVariables)) << expressions[i];
+        else
+            EXPECT_FALSE(parsed.compile().run(parsedVariables, result)) << expressions[i];
+    }
+}
+
+} // namespace
+
+TEST(TreeArchiveTest, StreamsRoundTrip)
+{
+    std::istringstream is(archive());
+    VariableMap variables;
+    TreeArchive archived(is, variables);
+    expectExpressions(archived, variables);
+
+    std::size_t found;
+    EXPECT_FALSE(archived.find("2+2", found));
+}
+
+TEST(TreeArchiveTest, FilesRoundTrip)
+{
+    auto path = testing::TempDir() + "tree_archive_test.eta";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << archive();
+    }
+    {
+        VariableMap variables;
+        TreeArchive archived(path, variables);
+        expectExpressions(archived, variables);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(TreeArchiveTest, TreesSaveAndLoad)
+{
+    for (auto expression : expressions) {
+        VariableMap variables;
+        auto tree = Interpreter::interpret(variables, expression);
+        std::stringstream archived;
+        tree.save(archived, variables);
+
+        VariableMap loadedVariables;
+        auto loaded = ExpressionTree::load(archived, loadedVariables);
+        EXPECT_EQ(structure(loaded), structure(tree)) << expression;
+    }
+}
+
+TEST(TreeArchiveTest, TruncatedArchivesAreRejected)
+{
+    auto whole = archive();
+    for (std::size_t length = 0; length < whole.size(); ++length) {
+        std::istringstream is(whole.substr(0, length));
+        VariableMap variables;
+        EXPECT_THROW(TreeArchive(is, variables), TreeArchive::InvalidArchive) << length;
+    }
+
+    std::istringstream empty("ETA1");
+    VariableMap variables;
+    EXPECT_THROW(ExpressionTree::load(empty, variables), TreeArchive::InvalidArchive);
+}
+
+TEST(TreeArchiveTest, CorruptArchivesAreRejected)
+{
+    // Corrupting any byte must either be caught as an InvalidArchive or
+    // still leave trees that can be built and evaluated.
+    auto whole = archive();
+    for (std::size_t at = 0; at < whole.size(); ++at) {
+        for (unsigned char flip : { 0x01, 0x80, 0xff }) {
+            auto corrupt = whole;
+            corrupt[at] = static_cast<char>(corrupt[at] ^ flip);
+            std::istringstream is(corrupt);
+            VariableMap variables;
+            try {
+                TreeArchive archived(is, variables);
+                assign(variables);
+                for (std::size_t i = 0; i < archived.size(); ++i) {
+                    (void)archived.tree(i);
+                    int result;
+                    try {
+                        archived.evaluate(i, variables, result);
+                    } catch (std::logic_error&) {
+                        // a corrupt tree can still be an invalid expression,
+                        // e.g. a factorial that's too big or an unset variable
+                    }
+                }
+            } catch (TreeArchive::InvalidArchive&) {
+            }
+        }
+    }
+}